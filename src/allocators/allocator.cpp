@@ -419,6 +419,197 @@ void SparseAllocator::PrintRequests( ostream * os ) const
   *os << "]." << endl;
 }
 
+//==================================================
+// BitsetAllocator
+//==================================================
+
+BitsetAllocator::BitsetAllocator( Module *parent, const string& name,
+				  int inputs, int outputs ) :
+  Allocator( parent, name, inputs, outputs ),
+  _in_words( ( outputs + 63 ) / 64 ), _out_words( ( inputs + 63 ) / 64 )
+{
+  _in_bits.resize(_inputs * _in_words, 0);
+  _out_bits.resize(_outputs * _out_words, 0);
+  _in_occ.resize(_out_words, 0);
+  _out_occ.resize(_in_words, 0);
+  _in_req.resize(_inputs);
+}
+
+void BitsetAllocator::Clear( )
+{
+  for ( int w = 0; w < _out_words; ++w ) {
+    for ( uint64_t occ = _in_occ[w]; occ; occ &= occ - 1 ) {
+      const int in = w * 64 + __builtin_ctzll( occ );
+      for ( int i = 0; i < _in_words; ++i ) {
+	_in_bits[in * _in_words + i] = 0;
+      }
+      _in_req[in].clear( );
+    }
+    _in_occ[w] = 0;
+  }
+
+  for ( int w = 0; w < _in_words; ++w ) {
+    for ( uint64_t occ = _out_occ[w]; occ; occ &= occ - 1 ) {
+      const int out = w * 64 + __builtin_ctzll( occ );
+      for ( int i = 0; i < _out_words; ++i ) {
+	_out_bits[out * _out_words + i] = 0;
+      }
+    }
+    _out_occ[w] = 0;
+  }
+
+  Allocator::Clear();
+}
+
+int BitsetAllocator::_FirstSet( const uint64_t * a, const uint64_t * b,
+				int words, int start )
+{
+  const int first = start / 64;
+  const uint64_t high = ~0ULL << ( start % 64 );
+
+  uint64_t bits = a[first] & ( b ? b[first] : ~0ULL ) & high;
+  if ( bits ) {
+    return first * 64 + __builtin_ctzll( bits );
+  }
+  for ( int i = 1; i <= words; ++i ) {
+    const int w = ( first + i ) % words;
+    bits = a[w] & ( b ? b[w] : ~0ULL );
+    if ( i == words ) {
+      // back in the first word, below start
+      bits &= ~high;
+    }
+    if ( bits ) {
+      return w * 64 + __builtin_ctzll( bits );
+    }
+  }
+  return -1;
+}
+
+int BitsetAllocator::ReadRequest( int in, int out ) const
+{
+  sRequest r;
+
+  if ( ! ReadRequest( r, in, out ) ) {
+    r.label = -1;
+  }
+
+  return r.label;
+}
+
+bool BitsetAllocator::ReadRequest( sRequest &req, int in, int out ) const
+{
+  assert( ( in >= 0 ) && ( in < _inputs ) );
+  assert( ( out >= 0 ) && ( out < _outputs ) );
+
+  if ( ! ( ( _InRow(in)[out / 64] >> ( out % 64 ) ) & 1 ) ) {
+    return false;
+  }
+  req = _in_req[in][_Rank(in, out)];
+  return true;
+}
+
+void BitsetAllocator::AddRequest( int in, int out, int label,
+				  int in_pri, int out_pri )
+{
+  Allocator::AddRequest(in, out, label, in_pri, out_pri);
+  assert( ReadRequest( in, out ) == -1 );
+
+  sRequest req;
+  req.port    = out;
+  req.label   = label;
+  req.in_pri  = in_pri;
+  req.out_pri = out_pri;
+
+  _in_req[in].insert( _in_req[in].begin( ) + _Rank(in, out), req );
+
+  _in_bits[in * _in_words + out / 64] |= 1ULL << ( out % 64 );
+  _out_bits[out * _out_words + in / 64] |= 1ULL << ( in % 64 );
+  _in_occ[in / 64] |= 1ULL << ( in % 64 );
+  _out_occ[out / 64] |= 1ULL << ( out % 64 );
+}
+
+void BitsetAllocator::RemoveRequest( int in, int out, int label )
+{
+  assert( ( in >= 0 ) && ( in < _inputs ) );
+  assert( ( out >= 0 ) && ( out < _outputs ) );
+  assert( ReadRequest( in, out ) == label );
+
+  _in_req[in].erase( _in_req[in].begin( ) + _Rank(in, out) );
+
+  _in_bits[in * _in_words + out / 64] &= ~( 1ULL << ( out % 64 ) );
+  _out_bits[out * _out_words + in / 64] &= ~( 1ULL << ( in % 64 ) );
+
+  // remove from the occupied sets if now empty
+  if ( _in_req[in].empty( ) ) {
+    _in_occ[in / 64] &= ~( 1ULL << ( in % 64 ) );
+  }
+  if ( !OutputHasRequests( out ) ) {
+    _out_occ[out / 64] &= ~( 1ULL << ( out % 64 ) );
+  }
+}
+
+bool BitsetAllocator::InputHasRequests( int in ) const
+{
+  return ( _in_occ[in / 64] >> ( in % 64 ) ) & 1;
+}
+
+bool BitsetAllocator::OutputHasRequests( int out ) const
+{
+  const uint64_t * column = _OutColumn(out);
+  for ( int w = 0; w < _out_words; ++w ) {
+    if ( column[w] ) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int BitsetAllocator::NumInputRequests( int in ) const
+{
+  return _in_req[in].size( );
+}
+
+int BitsetAllocator::NumOutputRequests( int out ) const
+{
+  const uint64_t * column = _OutColumn(out);
+  int result = 0;
+  for ( int w = 0; w < _out_words; ++w ) {
+    result += __builtin_popcountll( column[w] );
+  }
+  return result;
+}
+
+void BitsetAllocator::PrintRequests( ostream * os ) const
+{
+  if(!os) os = &cout;
+
+  *os << "Input requests = [ ";
+  for ( int input = 0; input < _inputs; ++input ) {
+    if(!_in_req[input].empty()) {
+      *os << input << " -> [ ";
+      for ( size_t i = 0; i < _in_req[input].size( ); ++i ) {
+	*os << _in_req[input][i].port << "@" << _in_req[input][i].in_pri << " ";
+      }
+      *os << "]  ";
+    }
+  }
+  *os << "], output requests = [ ";
+  for ( int output = 0; output < _outputs; ++output ) {
+    if(OutputHasRequests(output)) {
+      *os << output << " -> ";
+      *os << "[ ";
+      for ( int input = 0; input < _inputs; ++input ) {
+	sRequest req;
+	if ( ReadRequest( req, input, output ) ) {
+	  *os << input << "@" << req.out_pri << " ";
+	}
+      }
+      *os << "]  ";
+    }
+  }
+  *os << "]." << endl;
+}
+
 //==================================================
 // Global allocator allocation function
 //==================================================
@@ -451,7 +642,7 @@ Allocator *Allocator::NewAllocator( Module *parent, const string& name,
     a = new PIM( parent, name, inputs, outputs, iters );
   } else if ( alloc_name == "islip" ) {
     int iters = param_str.empty() ? (config ? config->GetInt("alloc_iters") : 1) : atoi(param_str.c_str());
-    a = new iSLIP_Sparse( parent, name, inputs, outputs, iters );
+    a = new iSLIP_Bitset( parent, name, inputs, outputs, iters );
   } else if ( alloc_name == "loa" ) {
     a = new LOA( parent, name, inputs, outputs );
   } else if ( alloc_name == "wavefront" ) {
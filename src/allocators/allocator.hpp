@@ -32,6 +32,7 @@
 #include <map>
 #include <set>
 #include <vector>
+#include <stdint.h>
 
 #include "module.hpp"
 #include "config_utils.hpp"
@@ -155,4 +156,69 @@ public:
 
 };
 
+//==================================================
+// A bitset allocator keeps one bit per (input,
+// output) pair, by row and by column, so that
+// allocators can scan requests a word at a time.
+// Each input's requests are stored in output order,
+// which keeps memory proportional to the requests.
+//==================================================
+
+class BitsetAllocator : public Allocator {
+protected:
+  const int _in_words;
+  const int _out_words;
+
+  vector<uint64_t> _in_bits;
+  vector<uint64_t> _out_bits;
+  vector<uint64_t> _in_occ;
+  vector<uint64_t> _out_occ;
+
+  vector<vector<sRequest> > _in_req;
+
+  inline const uint64_t * _InRow( int in ) const {
+    return &_in_bits[in * _in_words];
+  }
+  inline const uint64_t * _OutColumn( int out ) const {
+    return &_out_bits[out * _out_words];
+  }
+
+  // position of the request for out among the requests of in
+  inline int _Rank( int in, int out ) const {
+    const uint64_t * row = _InRow(in);
+    int rank = 0;
+    for ( int w = 0; w < out / 64; ++w ) {
+      rank += __builtin_popcountll( row[w] );
+    }
+    return rank + __builtin_popcountll( row[out / 64] & ( ( 1ULL << ( out % 64 ) ) - 1 ) );
+  }
+
+  // First set bit of (a & b) at or after start, wrapping around past the
+  // last of the given words; -1 if there is none. b may be NULL.
+  static int _FirstSet( const uint64_t * a, const uint64_t * b,
+			int words, int start );
+
+public:
+  BitsetAllocator( Module *parent, const string& name,
+		   int inputs, int outputs );
+
+  void Clear( );
+
+  int  ReadRequest( int in, int out ) const;
+  bool ReadRequest( sRequest &req, int in, int out ) const;
+
+  void AddRequest( int in, int out, int label = 1,
+		   int in_pri = 0, int out_pri = 0 );
+  void RemoveRequest( int in, int out, int label = 1 );
+
+  bool OutputHasRequests( int out ) const;
+  bool InputHasRequests( int in ) const;
+
+  int NumOutputRequests( int out ) const;
+  int NumInputRequests( int in ) const;
+
+  void PrintRequests( ostream * os = NULL ) const;
+
+};
+
 #endif
@@ -33,78 +33,62 @@
 
 //#define DEBUG_ISLIP
 
-iSLIP_Sparse::iSLIP_Sparse( Module *parent, const string& name,
+iSLIP_Bitset::iSLIP_Bitset( Module *parent, const string& name,
 			    int inputs, int outputs, int iters ) :
-  SparseAllocator( parent, name, inputs, outputs ),
+  BitsetAllocator( parent, name, inputs, outputs ),
   _iSLIP_iter(iters)
 {
   _gptrs.resize(_outputs, 0);
   _aptrs.resize(_inputs, 0);
+  _free_in.resize(_out_words);
+  _free_out.resize(_in_words);
+  _granted.resize(_inputs * _in_words, 0);
+  _granted_occ.resize(_out_words, 0);
 }
 
-void iSLIP_Sparse::Allocate( )
+void iSLIP_Bitset::Allocate( )
 {
-  int input;
-  int output;
-
-  int input_offset;
-  int output_offset;
-
-  map<int, sRequest>::iterator p;
-  bool wrapped;
+  _free_in.assign(_out_words, ~0ULL);
+  for ( int input = 0; input < _inputs; ++input ) {
+    if ( _inmatch[input] != -1 ) {
+      _free_in[input / 64] &= ~( 1ULL << ( input % 64 ) );
+    }
+  }
+  _free_out.assign(_in_words, ~0ULL);
+  for ( int output = 0; output < _outputs; ++output ) {
+    if ( _outmatch[output] != -1 ) {
+      _free_out[output / 64] &= ~( 1ULL << ( output % 64 ) );
+    }
+  }
 
   for ( int iter = 0; iter < _iSLIP_iter; ++iter ) {
     // Grant phase
 
-    vector<int> grants(_outputs, -1);
-
-    for ( output = 0; output < _outputs; ++output ) {
-
-      // Skip loop if there are no requests
-      // or the output is already matched
-      if ( ( _out_req[output].empty( ) ) ||
-	   ( _outmatch[output] != -1 ) ) {
-	continue;
-      }
-
-      // A round-robin arbiter between input requests
-      input_offset = _gptrs[output];
-
-      p = _out_req[output].begin( );
-      while( ( p != _out_req[output].end( ) ) &&
-	     ( p->second.port < input_offset ) ) {
-	p++;
-      }
-
-      wrapped = false;
-      while( (!wrapped) || 
-	     ( ( p != _out_req[output].end( ) ) &&
-	       ( p->second.port < input_offset ) ) ) {
-	if ( p == _out_req[output].end( ) ) {
-	  if ( wrapped ) { break; }
-	  // p is valid here because empty lists
-	  // are skipped (above)
-	  p = _out_req[output].begin( );
-	  wrapped = true;
-	}
-
-	input = p->second.port;
-
-	// we know the output is free (above) and
-	// if the input is free, grant request
-	if ( _inmatch[input] == -1 ) {
-	  grants[output] = input;
-	  break;
+    // Every free output with requests grants to the first free requesting
+    // input at or after its round-robin pointer; the grants are collected
+    // by input.
+    for ( int w = 0; w < _in_words; ++w ) {
+      for ( uint64_t outs = _out_occ[w] & _free_out[w]; outs; outs &= outs - 1 ) {
+	const int output = w * 64 + __builtin_ctzll( outs );
+	const int input = _FirstSet( _OutColumn(output), &_free_in[0],
+				     _out_words, _gptrs[output] );
+	if ( input >= 0 ) {
+	  _granted[input * _in_words + output / 64] |= 1ULL << ( output % 64 );
+	  _granted_occ[input / 64] |= 1ULL << ( input % 64 );
 	}
-
-	p++;
-      }      
+      }
     }
 
 #ifdef DEBUG_ISLIP
     cout << "grants: ";
     for ( int i = 0; i < _outputs; ++i ) {
-      cout << grants[i] << " ";
+      int g = -1;
+      for ( int j = 0; j < _inputs; ++j ) {
+	if ( ( _granted[j * _in_words + i / 64] >> ( i % 64 ) ) & 1 ) {
+	  g = j;
+	}
+      }
+      cout << g << " ";
     }
     cout << endl;
 
@@ -117,53 +101,32 @@ void iSLIP_Sparse::Allocate( )
 
     // Accept phase
 
-    for ( input = 0; input < _inputs; ++input ) {
-
-      if ( _in_req[input].empty( ) ) {
-	continue;
-      }
-
-      // A round-robin arbiter between output grants
-      output_offset = _aptrs[input];
-
-      p = _in_req[input].begin( );
-      while( ( p != _in_req[input].end( ) ) &&
-	     ( p->second.port < output_offset ) ) {
-	p++;
-      }
-
-      wrapped = false;
-      while( (!wrapped) || 
-	     ( ( p != _in_req[input].end( ) ) &&
-	       ( p->second.port < output_offset ) ) ) {
-	if ( p == _in_req[input].end( ) ) {
-	  if ( wrapped ) { break; }
-	  // p is valid here because empty lists
-	  // are skipped (above)
-	  p = _in_req[input].begin( );
-	  wrapped = true;
+    // Every input with grants accepts the first one at or after its
+    // round-robin pointer.
+    for ( int w = 0; w < _out_words; ++w ) {
+      for ( uint64_t ins = _granted_occ[w]; ins; ins &= ins - 1 ) {
+	const int input = w * 64 + __builtin_ctzll( ins );
+	uint64_t * granted = &_granted[input * _in_words];
+	const int output = _FirstSet( granted, NULL, _in_words, _aptrs[input] );
+	assert( output >= 0 );
+
+	// Accept
+	_inmatch[input]   = output;
+	_outmatch[output] = input;
+	_free_in[input / 64] &= ~( 1ULL << ( input % 64 ) );
+	_free_out[output / 64] &= ~( 1ULL << ( output % 64 ) );
+
+	// Only update pointers if accepted during the 1st iteration
+	if ( iter == 0 ) {
+	  _gptrs[output] = ( input + 1 ) % _inputs;
+	  _aptrs[input]  = ( output + 1 ) % _outputs;
 	}
 
-	output = p->second.port;
-
-	// we know the output is free (above) and
-	// if the input is free, grant request
-	if ( grants[output] == input ) {
-	  // Accept
-	  _inmatch[input]   = output;
-	  _outmatch[output] = input;
-
-	  // Only update pointers if accepted during the 1st iteration
-	  if ( iter == 0 ) {
-	    _gptrs[output] = ( input + 1 ) % _inputs;
-	    _aptrs[input]  = ( output + 1 ) % _outputs;
-	  }
-
-	  break;
+	for ( int i = 0; i < _in_words; ++i ) {
+	  granted[i] = 0;
 	}
-
-	p++;
-      } 
+      }
+      _granted_occ[w] = 0;
     }
   }
 
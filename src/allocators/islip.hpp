@@ -32,14 +32,20 @@
 
 #include "allocator.hpp"
 
-class iSLIP_Sparse : public SparseAllocator {
+class iSLIP_Bitset : public BitsetAllocator {
   int _iSLIP_iter;
 
   vector<int> _gptrs;
   vector<int> _aptrs;
 
+  // scratch state of one allocation
+  vector<uint64_t> _free_in;
+  vector<uint64_t> _free_out;
+  vector<uint64_t> _granted;
+  vector<uint64_t> _granted_occ;
+
 public:
-  iSLIP_Sparse( Module *parent, const string& name,
+  iSLIP_Bitset( Module *parent, const string& name,
 		int inputs, int outputs, int iters );
 
   void Allocate( );
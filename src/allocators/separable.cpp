@@ -40,7 +40,7 @@
 SeparableAllocator::SeparableAllocator( Module* parent, const string& name,
 					int inputs, int outputs,
 					const string& arb_type )
-  : SparseAllocator( parent, name, inputs, outputs )
+  : BitsetAllocator( parent, name, inputs, outputs )
 {
   
   _input_arb.resize(inputs);
@@ -82,5 +82,5 @@ void SeparableAllocator::Clear() {
     if(_output_arb[o]->_num_reqs)
       _output_arb[o]->Clear();
   }
-  SparseAllocator::Clear();
+  BitsetAllocator::Clear();
 }
@@ -40,7 +40,7 @@
 
 class Arbiter;
 
-class SeparableAllocator : public SparseAllocator {
+class SeparableAllocator : public BitsetAllocator {
   
 protected:
 
@@ -48,56 +48,53 @@ SeparableOutputFirstAllocator( Module* parent, const string& name, int inputs,
 
 void SeparableOutputFirstAllocator::Allocate() {
   
-  set<int>::const_iterator port_iter = _out_occ.begin();
-  while(port_iter != _out_occ.end()) {
-    
-    const int & output = *port_iter;
-
-    // add requests to the output arbiter
+  for(int w = 0; w < _in_words; ++w) {
+    for(uint64_t outs = _out_occ[w]; outs; outs &= outs - 1) {
 
-    map<int, sRequest>::const_iterator req_iter = _out_req[output].begin();
-    while(req_iter != _out_req[output].end()) {
-      
-      const sRequest & req = req_iter->second;
+      const int output = w * 64 + __builtin_ctzll(outs);
 
-      _output_arb[output]->AddRequest(req.port, req.label, req.out_pri);
+      // add requests to the output arbiter
 
-      ++req_iter;
-    }
+      const uint64_t * column = _OutColumn(output);
+      for(int v = 0; v < _out_words; ++v) {
+	for(uint64_t ins = column[v]; ins; ins &= ins - 1) {
+	  const int input = v * 64 + __builtin_ctzll(ins);
+	  const sRequest & req = _in_req[input][_Rank(input, output)];
+	  _output_arb[output]->AddRequest(input, req.label, req.out_pri);
+	}
+      }
     
-    // Execute the output arbiter and propagate the grants to the
-    // input arbiters.
+      // Execute the output arbiter and propagate the grants to the
+      // input arbiters.
 
-    int label = -1;
-    const int input = _output_arb[output]->Arbitrate(&label, NULL);
-    assert(input > -1);
+      int label = -1;
+      const int input = _output_arb[output]->Arbitrate(&label, NULL);
+      assert(input > -1);
 
-    const sRequest & req = _in_req[input][output];
-    assert((req.port == output) && (req.label == label));
+      const sRequest & req = _in_req[input][_Rank(input, output)];
+      assert((req.port == output) && (req.label == label));
 
-    _input_arb[input]->AddRequest(req.port, req.label, req.in_pri);
-
-    ++port_iter;
+      _input_arb[input]->AddRequest(req.port, req.label, req.in_pri);
+    }
   }
   
-  port_iter = _in_occ.begin();
-  while(port_iter != _in_occ.end()) {
-    
-    const int & input = *port_iter;
+  for(int w = 0; w < _out_words; ++w) {
+    for(uint64_t ins = _in_occ[w]; ins; ins &= ins - 1) {
+
+      const int input = w * 64 + __builtin_ctzll(ins);
 
-    // Execute the input arbiters.
+      // Execute the input arbiters.
     
-    const int output = _input_arb[input]->Arbitrate(NULL, NULL);
+      const int output = _input_arb[input]->Arbitrate(NULL, NULL);
   
-    if(output > -1) {
-      assert((_inmatch[input] == -1) && (_outmatch[output] == -1));
-
-      _inmatch[input] = output;
-      _outmatch[output] = input;
-      _input_arb[input]->UpdateState() ;
-      _output_arb[output]->UpdateState() ;
+      if(output > -1) {
+	assert((_inmatch[input] == -1) && (_outmatch[output] == -1));
+
+	_inmatch[input] = output;
+	_outmatch[output] = input;
+	_input_arb[input]->UpdateState() ;
+	_output_arb[output]->UpdateState() ;
+      }
     }
-    
-    ++port_iter;
   }
 }
@@ -46,6 +46,8 @@ BookSimConfig::BookSimConfig( )
 
   // Physical sub-networks
   _int_map["subnets"] = 1;
+  // Step each sub-network's routers and channels on its own thread
+  _int_map["parallel_subnets"] = 0;
 
   //==== Topology options =======================
   AddStrField( "topology", "torus" );
@@ -89,7 +91,7 @@ BookSimConfig::BookSimConfig( )
   //with switch speedup flits requires otuput buffering
   //full output buffer will cancel switch allocation requests
   //default setting is unlimited
-  //  _int_map["output_buffer_size"] = -1;
+  _int_map["output_buffer_size"] = -1;
   //_int_map["output_buffer_size_in_kb"] = 32768;    // 1MB = 32768 flits
   _int_map["output_buffer_size_in_kb"] = 1024;
 
@@ -183,6 +185,9 @@ BookSimConfig::BookSimConfig( )
   AddStrField("packet_size_rate", ""); // workaraound to allow for vector specification
 
   AddStrField( "injection_process", "bernoulli" );
+  // draw geometric gaps between injections instead of a random number per
+  // cycle (bernoulli and on_off only)
+  _int_map["injection_skip_ahead"] = 0;
 
   _float_map["burst_alpha"] = 0.5; // burst interval
   _float_map["burst_beta"]  = 0.5; // burst length
@@ -425,6 +430,45 @@ BookSimConfig::BookSimConfig( )
 
   _int_map["sim_count"]     = 1;   // number of simulations to perform
 
+  // Worker threads used to evaluate routers and channels of each network
+  // (1 = serial cycle engine)
+  _int_map["sim_threads"]   = 1;
+
+  // Give every router and endpoint its own counter-based random stream, so
+  // that results do not depend on the order in which modules are evaluated
+  _int_map["random_streams"] = 0;
+
+  // Fast-forward over cycles in which no module can change state
+  _int_map["idle_skip"]     = 1;
+
+  // Serial engine: only process routers and channels that have work
+  _int_map["active_set"]    = 0;
+
+  // Save the simulation state to this file after checkpoint_period sample
+  // periods / resume a simulation from such a file
+  AddStrField("checkpoint_save", "");
+  _int_map["checkpoint_period"] = 1;
+  _int_map["checkpoint_exit"] = 0; // stop once the checkpoint is written
+  AddStrField("checkpoint_restore", "");
+
+  // Run the simulation once for each value of sweep_param listed in
+  // sweep_values, sharing the first checkpoint_period sample periods;
+  // sweep_jobs points run at a time (0 = one per core)
+  AddStrField("sweep_param", "");
+  AddStrField("sweep_values", "");
+  _int_map["sweep_jobs"] = 0;
+  AddStrField("sweep_csv", "-");
+
+  // Write per-window router, channel and endpoint counters to a columnar
+  // binary file (see utils/telemetry.py)
+  AddStrField("telemetry_file", "");
+  _int_map["telemetry_window"] = 1000;
+  AddStrField("telemetry_counters", "{occupancy,channels,opb,drops,retransmits}");
+
+  // Report simulated cycles and flits per second at the end of the run
+  // (1), and also wall time and call counts per simulator phase (2)
+  _int_map["profile"] = 0;
+
 
   //_int_map["include_queuing"] =1; // non-zero includes source queuing latency
   _int_map["include_queuing"] =0; // non-zero includes source queuing latency
@@ -483,6 +527,10 @@ BookSimConfig::BookSimConfig( )
 
   //==================Network file===========================
   AddStrField("network_file","");
+  // threads computing the anynet routing tables, 0 = one per hardware thread
+  _int_map["anynet_threads"] = 0;
+  // directory for cached anynet topologies and routing tables, "" = no cache
+  AddStrField("anynet_cache","");
 
   //==================SWM configs and arguments===========================
   //
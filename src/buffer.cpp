@@ -26,6 +26,7 @@
 */
 
 #include <sstream>
+#include <algorithm>
 
 #include "globals.hpp"
 #include "booksim.hpp"
@@ -44,10 +45,19 @@ Module( parent, name ), _occupancy(0)
 
   _vc.resize(num_vcs);
 
+  // Each VC gets a ring of at least vc_buf_size slots, but never more than
+  // the whole buffer holds.
+  int const vc_buf_size = min(max(config.GetInt( "vc_buf_size" ), 1), max(_size, 1));
+  int ring = 1;
+  while(ring < vc_buf_size) {
+    ring *= 2;
+  }
+  _slab.resize(num_vcs * ring);
+
   for(int i = 0; i < num_vcs; ++i) {
     ostringstream vc_name;
     vc_name << "vc_" << i;
-    _vc[i] = new VC(config, outputs, this, vc_name.str( ) );
+    _vc[i] = new VC(config, outputs, this, vc_name.str( ), &_slab[i * ring], ring );
   }
 
 #ifdef TRACK_BUFFERS
@@ -63,15 +73,21 @@ Buffer::~Buffer()
   }
 }
 
-void Buffer::AddFlit( int vc, Flit *f )
+void Buffer::_Overflow( ) const
+{
+  Error("Flit buffer overflow.");
+}
+
+void Buffer::Checkpoint( CheckpointFile & cp )
 {
-  if(_occupancy >= _size) {
-    Error("Flit buffer overflow.");
+  cp.Check( FullName( ) + " size", _size );
+  cp.Check( FullName( ) + " vcs", _vc.size( ) );
+  cp.Io( _occupancy );
+  for(vector<VC*>::iterator i = _vc.begin(); i != _vc.end(); ++i) {
+    (*i)->Checkpoint( cp );
   }
-  ++_occupancy;
-  _vc[vc]->AddFlit(f);
 #ifdef TRACK_BUFFERS
-  ++_class_occupancy[f->cl];
+  cp.Io( _class_occupancy );
 #endif
 }
 
@@ -43,6 +43,11 @@ class Buffer : public Module {
 
   vector<VC*> _vc;
 
+  // storage of all VC rings, one after the other
+  vector<Flit::Handle> _slab;
+
+  void _Overflow( ) const;
+
 #ifdef TRACK_BUFFERS
   vector<int> _class_occupancy;
 #endif
@@ -53,7 +58,17 @@ public:
 	  Module *parent, const string& name );
   ~Buffer();
 
-  void AddFlit( int vc, Flit *f );
+  inline void AddFlit( int vc, Flit *f )
+  {
+    if(_occupancy >= _size) {
+      _Overflow( );
+    }
+    ++_occupancy;
+    _vc[vc]->AddFlit(f);
+#ifdef TRACK_BUFFERS
+    ++_class_occupancy[f->cl];
+#endif
+  }
 
   inline Flit *RemoveFlit( int vc )
   {
@@ -160,6 +175,8 @@ public:
   }
 #endif
 
+  void Checkpoint( CheckpointFile & cp );
+
   void Display( ostream & os = cout ) const;
 };
 
@@ -255,6 +255,13 @@ int BufferState::SharedBufferPolicy::AvailableFor(int vc) const
 	  (_shared_buf_size - _shared_buf_occupancy));
 }
 
+void BufferState::SharedBufferPolicy::Checkpoint(CheckpointFile & cp)
+{
+  cp.Io(_private_buf_occupancy);
+  cp.Io(_shared_buf_occupancy);
+  cp.Io(_reserved_slots);
+}
+
 int BufferState::SharedBufferPolicy::LimitFor(int vc) const
 {
   int i = _private_buf_vc_map[vc];
@@ -302,6 +309,12 @@ int BufferState::LimitedSharedBufferPolicy::AvailableFor(int vc) const
 	     _max_held_slots - _buffer_state->OccupancyFor(vc));
 }
 
+void BufferState::LimitedSharedBufferPolicy::Checkpoint(CheckpointFile & cp)
+{
+  SharedBufferPolicy::Checkpoint(cp);
+  cp.Io(_active_vcs);
+}
+
 int BufferState::LimitedSharedBufferPolicy::LimitFor(int vc) const
 {
   return min(SharedBufferPolicy::LimitFor(vc), _max_held_slots);
@@ -484,6 +497,15 @@ int BufferState::FeedbackSharedBufferPolicy::AvailableFor(int vc) const
 	     _ComputeMaxSlots(vc) - _buffer_state->OccupancyFor(vc));
 }
 
+void BufferState::FeedbackSharedBufferPolicy::Checkpoint(CheckpointFile & cp)
+{
+  SharedBufferPolicy::Checkpoint(cp);
+  cp.Io(_occupancy_limit);
+  cp.Io(_round_trip_time);
+  cp.Io(_flit_sent_time);
+  cp.Io(_total_mapped_size);
+}
+
 int BufferState::FeedbackSharedBufferPolicy::LimitFor(int vc) const
 {
   return min(SharedBufferPolicy::LimitFor(vc), _ComputeMaxSlots(vc));
@@ -536,6 +558,12 @@ void BufferState::SimpleFeedbackSharedBufferPolicy::FreeSlotFor(int vc)
   SharedBufferPolicy::FreeSlotFor(vc);
 }
 
+void BufferState::SimpleFeedbackSharedBufferPolicy::Checkpoint(CheckpointFile & cp)
+{
+  FeedbackSharedBufferPolicy::Checkpoint(cp);
+  cp.Io(_pending_credits);
+}
+
 BufferState::BufferState( const Configuration& config, Module *parent, const string& name ) : 
   Module( parent, name ), _occupancy(0)
 {
@@ -573,7 +601,7 @@ void BufferState::ProcessCredit( Credit const * const c )
 {
   assert( c );
 
-  set<int>::iterator iter = c->vc.begin();
+  Credit::VCSet::const_iterator iter = c->vc.begin();
   while(iter != c->vc.end()) {
 
     int const vc = *iter;
@@ -663,6 +691,23 @@ void BufferState::TakeBuffer( int vc, int tag )
   _buffer_policy->TakeBuffer(vc);
 }
 
+void BufferState::Checkpoint( CheckpointFile & cp )
+{
+  cp.Check( FullName( ) + " size", _size );
+  cp.Check( FullName( ) + " vcs", _vcs );
+  cp.Io( _occupancy );
+  cp.Io( _vc_occupancy );
+  cp.Io( _in_use_by );
+  cp.Io( _tail_sent );
+  cp.Io( _last_id );
+  cp.Io( _last_pid );
+#ifdef TRACK_BUFFERS
+  cp.Io( _outstanding_classes );
+  cp.Io( _class_occupancy );
+#endif
+  _buffer_policy->Checkpoint( cp );
+}
+
 void BufferState::Display( ostream & os ) const
 {
   os << FullName() << " :" << endl;
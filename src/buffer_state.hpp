@@ -35,6 +35,7 @@
 #include "flit.hpp"
 #include "credit.hpp"
 #include "config_utils.hpp"
+#include "checkpoint.hpp"
 
 class BufferState : public Module {
   
@@ -51,6 +52,7 @@ class BufferState : public Module {
     virtual bool IsFullFor(int vc = 0) const = 0;
     virtual int AvailableFor(int vc = 0) const = 0;
     virtual int LimitFor(int vc = 0) const = 0;
+    virtual void Checkpoint(CheckpointFile & cp) {}
 
     static BufferPolicy * New(Configuration const & config, 
 			      BufferState * parent, const string & name);
@@ -86,6 +88,7 @@ class BufferState : public Module {
     virtual bool IsFullFor(int vc = 0) const;
     virtual int AvailableFor(int vc = 0) const;
     virtual int LimitFor(int vc = 0) const;
+    virtual void Checkpoint(CheckpointFile & cp);
   };
 
   class LimitedSharedBufferPolicy : public SharedBufferPolicy {
@@ -102,6 +105,7 @@ class BufferState : public Module {
     virtual bool IsFullFor(int vc = 0) const;
     virtual int AvailableFor(int vc = 0) const;
     virtual int LimitFor(int vc = 0) const;
+    virtual void Checkpoint(CheckpointFile & cp);
   };
     
   class DynamicLimitedSharedBufferPolicy : public LimitedSharedBufferPolicy {
@@ -144,6 +148,7 @@ class BufferState : public Module {
     virtual bool IsFullFor(int vc = 0) const;
     virtual int AvailableFor(int vc = 0) const;
     virtual int LimitFor(int vc = 0) const;
+    virtual void Checkpoint(CheckpointFile & cp);
   };
   
   class SimpleFeedbackSharedBufferPolicy : public FeedbackSharedBufferPolicy {
@@ -154,6 +159,7 @@ class BufferState : public Module {
 				     BufferState * parent, const string & name);
     virtual void SendingFlit(Flit const * const f);
     virtual void FreeSlotFor(int vc = 0);
+    virtual void Checkpoint(CheckpointFile & cp);
   };
   
   bool _wait_for_tail_credit;
@@ -233,6 +239,8 @@ public:
   }
 #endif
 
+  void Checkpoint( CheckpointFile & cp );
+
   void Display( ostream & os = cout ) const;
 };
 
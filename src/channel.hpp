@@ -37,12 +37,13 @@
 #ifndef _CHANNEL_HPP
 #define _CHANNEL_HPP
 
-#include <queue>
+#include <vector>
 #include <cassert>
 
 #include "globals.hpp"
 #include "module.hpp"
 #include "timed_module.hpp"
+#include "checkpoint.hpp"
 
 using namespace std;
 
@@ -66,17 +67,44 @@ public:
   virtual void Evaluate() {}
   virtual void WriteOutputs();
 
+  virtual bool IsIdle() const {
+    return !_input && !_output && !_in_flight;
+  }
+
+  virtual void Checkpoint(CheckpointFile & cp);
+
+  // Active-set scheduling (see Network): a channel that is not on its
+  // network's worklist adds its index to it when something is sent into it.
+  void SetWorklist(vector<int> * worklist, int index) {
+    _worklist = worklist;
+    _worklist_index = index;
+  }
+  void SetListed(bool listed) { _listed = listed; }
+
 protected:
   int _delay;
   T * _input;
   T * _output;
-  queue<pair<int, T *> > _wait_queue;
+
+  // Fixed-latency delay line, one slot per cycle of latency. Slot _head is
+  // delivered by the next WriteOutputs; an item accepted by ReadInputs goes
+  // _delay-1 slots behind it. _head only moves while something is in
+  // flight, so the line needs no notion of the current cycle.
+  vector<T *> _line;
+  int _head;
+  int _in_flight;
+
+  vector<int> * _worklist;
+  int _worklist_index;
+  bool _listed;
 
 };
 
 template<typename T>
 Channel<T>::Channel(Module * parent, string const & name)
-  : TimedModule(parent, name), _delay(1), _input(0), _output(0) {
+  : TimedModule(parent, name), _delay(1), _input(0), _output(0),
+    _line(1, 0), _head(0), _in_flight(0),
+    _worklist(0), _worklist_index(-1), _listed(false) {
 }
 
 template<typename T>
@@ -84,12 +112,19 @@ void Channel<T>::SetLatency(int cycles) {
   if(cycles <= 0) {
     Error("Channel must have positive delay.");
   }
+  assert(!_in_flight);
   _delay = cycles ;
+  _line.assign(_delay, 0);
+  _head = 0;
 }
 
 template<typename T>
 void Channel<T>::Send(T * data) {
   _input = data;
+  if(data && _worklist && !_listed) {
+    _listed = true;
+    _worklist->push_back(_worklist_index);
+  }
 }
 
 template<typename T>
@@ -100,26 +135,41 @@ T * Channel<T>::Receive() {
 template<typename T>
 void Channel<T>::ReadInputs() {
   if(_input) {
-    _wait_queue.push(make_pair(GetSimTime() + _delay - 1, _input));
+    int slot = _head + _delay - 1;
+    if(slot >= _delay) {
+      slot -= _delay;
+    }
+    assert(!_line[slot]);
+    _line[slot] = _input;
+    ++_in_flight;
     _input = 0;
   }
 }
 
+template<typename T>
+void Channel<T>::Checkpoint(CheckpointFile & cp) {
+  cp.Check(FullName() + " latency", _delay);
+  cp.Io(_input);
+  cp.Io(_output);
+  cp.Io(_line);
+  cp.Io(_head);
+  cp.Io(_in_flight);
+}
+
 template<typename T>
 void Channel<T>::WriteOutputs() {
-  _output = 0;
-  if(_wait_queue.empty()) {
+  if(!_in_flight) {
+    _output = 0;
     return;
   }
-  pair<int, T *> const & item = _wait_queue.front();
-  int const & time = item.first;
-  if(GetSimTime() < time) {
-    return;
+  _output = _line[_head];
+  if(_output) {
+    _line[_head] = 0;
+    --_in_flight;
+  }
+  if(++_head == _delay) {
+    _head = 0;
   }
-  assert(GetSimTime() == time);
-  _output = item.second;
-  assert(_output);
-  _wait_queue.pop();
 }
 
 #endif
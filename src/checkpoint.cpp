@@ -0,0 +1,122 @@
+/*checkpoint.cpp
+ *
+ *Binary archive for simulation checkpoints
+ *
+ */
+
+#include <iostream>
+#include <sstream>
+
+#include "booksim.hpp"
+#include "checkpoint.hpp"
+#include "flit.hpp"
+#include "credit.hpp"
+
+static char const CHECKPOINT_MAGIC[] = "booksim-checkpoint-1";
+
+CheckpointFile::CheckpointFile( string const & filename, bool save )
+  : _filename( filename ), _save( save )
+{
+  _file = fopen( filename.c_str( ), save ? "wb" : "rb" );
+  if ( !_file ) {
+    Error( save ? "cannot create file" : "cannot open file" );
+  }
+  string magic = CHECKPOINT_MAGIC;
+  Io( magic );
+  if ( magic != CHECKPOINT_MAGIC ) {
+    Error( "not a checkpoint file" );
+  }
+}
+
+CheckpointFile::~CheckpointFile( )
+{
+  if ( fclose( _file ) != 0 ) {
+    Error( "write failed" );
+  }
+}
+
+void CheckpointFile::Error( string const & msg ) const
+{
+  cout << "Error in checkpoint " << _filename << " : " << msg << endl;
+  exit( -1 );
+}
+
+void CheckpointFile::Raw( void * data, size_t bytes )
+{
+  size_t const done = _save ? fwrite( data, 1, bytes, _file ) : fread( data, 1, bytes, _file );
+  if ( done != bytes ) {
+    Error( _save ? "write failed" : "unexpected end of file" );
+  }
+}
+
+void CheckpointFile::Check( string const & what, int64_t value )
+{
+  int64_t saved = value;
+  Io( saved );
+  if ( saved != value ) {
+    ostringstream err;
+    err << what << " is " << value << " but the checkpoint was taken with " << saved;
+    Error( err.str( ) );
+  }
+}
+
+void CheckpointFile::Io( Flit * & f )
+{
+  // On restore f may still point into the arena that is being replaced.
+  uint32_t h = ( _save && f ) ? f->GetHandle( ) : UINT32_MAX;
+  Io( h );
+  if ( !_save ) {
+    f = ( h == UINT32_MAX ) ? NULL : Flit::FromHandle( h );
+  }
+}
+
+void CheckpointFile::Io( Credit * & c )
+{
+  bool present = _save && ( c != NULL );
+  Io( present );
+  if ( !present ) {
+    c = NULL;
+    return;
+  }
+  vector<int> vcs;
+  if ( _save ) {
+    vcs.assign( c->vc.begin( ), c->vc.end( ) );
+  } else {
+    c = Credit::New( );
+  }
+  Io( vcs );
+  Io( c->head );
+  Io( c->tail );
+  Io( c->id );
+  if ( !_save ) {
+    for ( size_t i = 0; i < vcs.size( ); ++i ) {
+      c->vc.insert( vcs[i] );
+    }
+  }
+}
+
+void CheckpointFile::Io( string & s )
+{
+  uint64_t n = s.size( );
+  Io( n );
+  if ( !_save ) {
+    s.resize( n );
+  }
+  if ( n ) {
+    Raw( &s[0], n );
+  }
+}
+
+void CheckpointFile::Io( vector<bool> & v )
+{
+  uint64_t n = v.size( );
+  Io( n );
+  if ( !_save ) {
+    v.assign( n, false );
+  }
+  for ( uint64_t i = 0; i < n; ++i ) {
+    bool b = v[i];
+    Io( b );
+    v[i] = b;
+  }
+}
@@ -0,0 +1,154 @@
+/*checkpoint.hpp
+ *
+ *Binary archive for saving the state of a running simulation to a file and
+ *loading it back into a simulator built from the same configuration. The
+ *same Io() calls serve both directions, so every class describes its state
+ *once, in a Checkpoint() method.
+ *
+ *Flits are saved with the flit arena and referenced by handle; credits are
+ *saved by value wherever they are held. Classes and structs that contain
+ *pointers provide a Checkpoint(CheckpointFile &) method, which Io() calls in
+ *preference to copying the raw bytes.
+ *
+ */
+
+#ifndef _CHECKPOINT_HPP_
+#define _CHECKPOINT_HPP_
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <deque>
+#include <list>
+#include <queue>
+#include <map>
+#include <set>
+#include <utility>
+#include <type_traits>
+#include <stdint.h>
+
+using namespace std;
+
+class Flit;
+class Credit;
+
+class CheckpointFile {
+
+public:
+  CheckpointFile( string const & filename, bool save );
+  ~CheckpointFile( );
+
+  inline bool IsSaving( ) const { return _save; }
+
+  void Error( string const & msg ) const;
+
+  void Raw( void * data, size_t bytes );
+
+  // Records a structural value (node count, router radix, ...) on save and
+  // verifies it on restore, so that a checkpoint from a different
+  // configuration is rejected instead of being misread.
+  void Check( string const & what, int64_t value );
+
+  template<class T> inline void Io( T & value ) {
+    _Io( value, 0 );
+  }
+
+  void Io( Flit * & f );
+  void Io( Credit * & c );
+  void Io( string & s );
+  void Io( vector<bool> & v );
+
+  // On restore, resizes the container to the saved element count.
+  template<class C> void IoSize( C & c ) {
+    uint64_t n = c.size( );
+    Io( n );
+    if ( !_save ) {
+      c.clear( );
+      c.resize( n );
+    }
+  }
+
+  template<class T> void Io( vector<T> & v ) {
+    IoSize( v );
+    for ( size_t i = 0; i < v.size( ); ++i ) {
+      Io( v[i] );
+    }
+  }
+
+  template<class T> void Io( deque<T> & d ) {
+    IoSize( d );
+    for ( typename deque<T>::iterator iter = d.begin( ); iter != d.end( ); ++iter ) {
+      Io( *iter );
+    }
+  }
+
+  template<class T> void Io( list<T> & l ) {
+    IoSize( l );
+    for ( typename list<T>::iterator iter = l.begin( ); iter != l.end( ); ++iter ) {
+      Io( *iter );
+    }
+  }
+
+  template<class T> void Io( queue<T> & q ) {
+    deque<T> items;
+    if ( _save ) {
+      for ( queue<T> copy = q; !copy.empty( ); copy.pop( ) ) {
+        items.push_back( copy.front( ) );
+      }
+    }
+    Io( items );
+    if ( !_save ) {
+      q = queue<T>( items );
+    }
+  }
+
+  template<class A, class B> void Io( pair<A, B> & p ) {
+    Io( p.first );
+    Io( p.second );
+  }
+
+  template<class K, class V> void Io( map<K, V> & m ) {
+    uint64_t n = m.size( );
+    Io( n );
+    if ( _save ) {
+      for ( typename map<K, V>::iterator iter = m.begin( ); iter != m.end( ); ++iter ) {
+        K key = iter->first;
+        Io( key );
+        Io( iter->second );
+      }
+    } else {
+      m.clear( );
+      for ( uint64_t i = 0; i < n; ++i ) {
+        K key;
+        Io( key );
+        Io( m[key] );
+      }
+    }
+  }
+
+  template<class T> void Io( set<T> & s ) {
+    vector<T> items( s.begin( ), s.end( ) );
+    Io( items );
+    if ( !_save ) {
+      s = set<T>( items.begin( ), items.end( ) );
+    }
+  }
+
+private:
+  template<class T>
+  auto _Io( T & value, int ) -> decltype( value.Checkpoint( *this ), void( ) ) {
+    value.Checkpoint( *this );
+  }
+
+  template<class T> void _Io( T & value, long ) {
+    static_assert( is_trivially_copyable<T>::value && !is_pointer<T>::value,
+                   "type needs a Checkpoint() method" );
+    Raw( &value, sizeof( T ) );
+  }
+
+  string _filename;
+  bool _save;
+  FILE * _file;
+};
+
+#endif
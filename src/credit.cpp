@@ -32,9 +32,12 @@
 
 #include "booksim.hpp"
 #include "credit.hpp"
+#include "checkpoint.hpp"
 
 stack<Credit *> Credit::_all;
 stack<Credit *> Credit::_free;
+bool Credit::_thread_safe = false;
+mutex Credit::_lock;
 
 Credit::Credit()
 {
@@ -50,6 +53,10 @@ void Credit::Reset()
 }
 
 Credit * Credit::New() {
+  unique_lock<mutex> guard(_lock, defer_lock);
+  if(_thread_safe) {
+    guard.lock();
+  }
   Credit * c;
   if(_free.empty()) {
     c = new Credit();
@@ -63,6 +70,10 @@ Credit * Credit::New() {
 }
 
 void Credit::Free() {
+  unique_lock<mutex> guard(_lock, defer_lock);
+  if(_thread_safe) {
+    guard.lock();
+  }
   _free.push(this);
 }
 
@@ -77,3 +88,12 @@ void Credit::FreeAll() {
 int Credit::OutStanding(){
   return _all.size()-_free.size();
 }
+
+void Credit::Checkpoint(CheckpointFile & cp) {
+  if(!cp.IsSaving()) {
+    _free = stack<Credit *>();
+    for(stack<Credit *> all = _all; !all.empty(); all.pop()) {
+      _free.push(all.top());
+    }
+  }
+}
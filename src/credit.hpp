@@ -28,14 +28,44 @@
 #ifndef _CREDIT_HPP_
 #define _CREDIT_HPP_
 
-#include <set>
+#include <vector>
 #include <stack>
+#include <mutex>
+
+class CheckpointFile;
 
 class Credit {
 
 public:
 
-  set<int> vc;
+  // Ascending, duplicate-free list of the VCs a credit returns. It nearly
+  // always holds one entry, and its storage survives Reset() so recycled
+  // credits do not allocate.
+  class VCSet {
+  public:
+    typedef vector<int>::const_iterator const_iterator;
+
+    inline const_iterator begin() const { return _vcs.begin(); }
+    inline const_iterator end() const { return _vcs.end(); }
+    inline size_t size() const { return _vcs.size(); }
+    inline bool empty() const { return _vcs.empty(); }
+    inline void clear() { _vcs.clear(); }
+
+    inline void insert(int vc) {
+      vector<int>::iterator iter = _vcs.end();
+      while((iter != _vcs.begin()) && (*(iter - 1) > vc)) {
+	--iter;
+      }
+      if((iter == _vcs.begin()) || (*(iter - 1) != vc)) {
+	_vcs.insert(iter, vc);
+      }
+    }
+
+  private:
+    vector<int> _vcs;
+  };
+
+  VCSet vc;
 
   // these are only used by the event router
   bool head, tail;
@@ -47,11 +77,22 @@ public:
   void Free();
   static void FreeAll();
   static int OutStanding();
+
+  // Credits are saved by value where they are held; on restore this returns
+  // the whole pool to the free list before the holders allocate theirs.
+  static void Checkpoint(CheckpointFile & cp);
+
+  // Guard the free list when credits are allocated and released from the
+  // worker threads of the parallel engine.
+  static void SetThreadSafe(bool thread_safe) { _thread_safe = thread_safe; }
 private:
 
   static stack<Credit *> _all;
   static stack<Credit *> _free;
 
+  static bool _thread_safe;
+  static mutex _lock;
+
   Credit();
   ~Credit() {}
 
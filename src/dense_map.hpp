@@ -0,0 +1,55 @@
+/*dense_map.hpp
+ *
+ *Map-like container for small non-negative integer keys (node ids). Values
+ *live in a flat array indexed by key; a per-key flag remembers which keys
+ *have been touched so count() keeps std::map semantics, where operator[]
+ *inserts a default-constructed value on first access.
+ *
+ */
+
+#ifndef _DENSE_MAP_HPP_
+#define _DENSE_MAP_HPP_
+
+#include <vector>
+#include <cassert>
+
+using namespace std;
+
+template<class T> class DenseMap {
+
+public:
+  DenseMap( ) : _size(0) {}
+
+  // Discards all entries and makes keys [0, keys) addressable.
+  void reset( size_t keys ) {
+    _values.assign(keys, T());
+    _present.assign(keys, 0);
+    _size = 0;
+  }
+
+  inline T & operator[]( size_t key ) {
+    assert( key < _values.size( ) );
+    if ( !_present[key] ) {
+      _present[key] = 1;
+      ++_size;
+    }
+    return _values[key];
+  }
+
+  inline size_t count( size_t key ) const {
+    return ( ( key < _present.size( ) ) && _present[key] ) ? 1 : 0;
+  }
+
+  inline size_t size( ) const { return _size; }
+
+  // Upper bound on keys, for iterating in ascending key order together with
+  // count().
+  inline size_t keys( ) const { return _values.size( ); }
+
+private:
+  vector<T> _values;
+  vector<char> _present;
+  size_t _size;
+};
+
+#endif
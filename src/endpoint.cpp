@@ -6,11 +6,15 @@
 
 #include "random_utils.hpp"
 #include "outputset.hpp"
+#include "profiler.hpp"
 
 EndPoint::EndPoint(Configuration const & config, TrafficManager * parent,
                    const string & name, int nodeid):
   TimedModule( parent, name ), _nodeid( nodeid ), _parent( parent ) {
 
+  _random.SetId(FullName());
+
+  _debug_enabled = false;
   vector<string> debug_endpoint_vec = config.GetStrArray("debug_endpoint");
   if (debug_endpoint_vec.empty()) {
     string debug_endpoint = config.GetStr("debug_endpoint");
@@ -46,6 +50,7 @@ EndPoint::EndPoint(Configuration const & config, TrafficManager * parent,
       }
     } else {
       // By default al endpoints experinece host congestion
+      _mypolicy_endpoint.host_congestion_enabled = true;
     }
   }
 
@@ -104,14 +109,19 @@ EndPoint::EndPoint(Configuration const & config, TrafficManager * parent,
     _full_packets_in_inj_buf[traffic_class].resize(_num_injection_queues, 0);
   }
   _generated_packets.resize(_classes, 0);
+  _generated_packets_full_sim = 0;
   _generated_flits.resize(_classes, 0);
+  _generated_flits_full_sim = 0;
   _injected_flits.resize(_classes, 0);
   _sent_flits.resize(_classes, 0);
   _sent_packets.resize(_classes, 0);
+  _sent_data_flits = 0;
   _new_sent_flits.resize(_classes, 0);
   _new_sent_packets.resize(_classes, 0);
+  _new_sent_data_flits = 0;
   _received_flits.resize(_classes, 0);
   _received_packets.resize(_classes, 0);
+  _received_data_flits = 0;
   _qtime.resize(_classes, 0);
   _qdrained.resize(_classes, false);
   _last_class.resize(_subnets,0);
@@ -157,11 +167,13 @@ EndPoint::EndPoint(Configuration const & config, TrafficManager * parent,
   _opb_dest_idx_mask = (1UL << config.GetInt("opb_dest_idx_bits")) - 1;
   _opb_seq_num_bits  = config.GetInt("opb_seq_num_idx_bits");
   _opb_seq_num_idx_mask = (1UL << _opb_seq_num_bits) - 1;
+  _opb_occupancy_map.resize((_opb_dest_idx_mask + 1) << _opb_seq_num_bits, 0);
   _inj_buf_depth = config.GetInt("inj_buf_depth");
 
   int flit_size = 32; // in bytes
   _retry_timer_timeout = config.GetInt("retry_timer_timeout");
 
+  _mypolicy_constant.policy = config.GetInt("host_control_policy");
   if (_mypolicy_constant.policy == HC_HOMA_POLICY)
     _retry_timer_timeout = _estimate_round_trip_cycle * 3;
 
@@ -288,7 +300,6 @@ EndPoint::EndPoint(Configuration const & config, TrafficManager * parent,
   _put_buffer_meta.packet_dropped = 0;
   _put_buffer_meta.packet_dropped_full = 0;
 
-  _mypolicy_constant.policy = config.GetInt("host_control_policy");
   if (_mypolicy_constant.policy == HC_MY_POLICY) {
     _mypolicy_constant.delayed_ack_threshold =
         config.GetInt("mypolicy_delayed_ack_threshold");
@@ -340,7 +351,6 @@ EndPoint::EndPoint(Configuration const & config, TrafficManager * parent,
   _mypolicy_endpoint.data_dequeued_but_need_acked = 0;
   _mypolicy_endpoint.latency = new Stats( this, "latency", 1.0, 1000 );
   _mypolicy_endpoint.latency->Clear();
-  _mypolicy_endpoint.latency->_need_percentile = true;
 
   // Gbps to flit / Cycles
   //
@@ -362,6 +372,26 @@ EndPoint::EndPoint(Configuration const & config, TrafficManager * parent,
   _mypolicy_endpoint.ecn_next_check_period = 0;
 
 
+  // Per-dest state is indexed directly by node id.
+  _packet_seq_num.resize(_endpoints);
+  _recvd_seq_num_vec.resize(_endpoints);
+  _mypolicy_connections.resize(_endpoints);
+  _ack_response_state.resize(_endpoints);
+  _retry_state_tracker.resize(_endpoints);
+  _outstanding_packet_buffer.reset(_endpoints);
+  _outstanding_xactions_per_dest.resize(_endpoints);
+  _outstanding_put_data_per_dest.resize(_endpoints);
+  _outstanding_put_data_samples_per_dest.resize(_endpoints);
+  _new_write_ack_data_per_dest.resize(_endpoints);
+  _new_write_ack_data_samples_per_dest.resize(_endpoints);
+  _periods_since_last_transition.resize(_endpoints);
+  _converting_puts_to_rgets.resize(_endpoints);
+  _outstanding_gets_per_dest.resize(_endpoints);
+  _outstanding_rget_reqs_per_dest.resize(_endpoints);
+  _outstanding_outbound_data_per_dest.resize(_endpoints);
+  _outstanding_inbound_data_per_dest.resize(_endpoints);
+  _outstanding_rget_inbound_data_per_dest.resize(_endpoints);
+
   for (unsigned int target = 0; target < _endpoints; target++) {
     // Transmitted sequence numbers start with 1.
     _packet_seq_num[target] = 1;
@@ -438,6 +468,8 @@ EndPoint::EndPoint(Configuration const & config, TrafficManager * parent,
   _cycles_gen_attempted_but_blocked = 0;
   _cycles_inj_present_but_blocked = 0;
   _cycles_new_flit_not_injected = 0;
+  _cycles_new_flit_not_injected_due_to_packet_processing_penalty = 0;
+  _cycles_new_flit_not_injected_due_to_staging_buffer_full = 0;
   _cycles_link_avail_no_new_flits = 0;
   _cycles_retransmitting = 0;
   _packets_retransmitted = 0;
@@ -476,6 +508,7 @@ EndPoint::~EndPoint() {
 
 //void EndPoint::_Inject() {
 void EndPoint::_EvaluateNewPacketInjection() {
+  RandomStreamScope random_scope(&_random);
   // Depending on the state of the endpoint, determine whether we want to
   // attempt to generate/inject a new packet.
 
@@ -998,13 +1031,17 @@ bool EndPoint::check_for_opb_insertion_conflict(int target) {
 // the various buffers and passes it up to the trafficmanager to put the flit
 // onto the network wires.
 Flit * EndPoint::_Step(int subnet) {
+  PROFILE_PHASE( ENDPOINT_INJECT );
+  RandomStreamScope random_scope(&_random);
 
 
   if(_cur_time == gLastClearStatTime) {
     printf("Displaying and clearing stats...%d\n", _cur_time);
     _parent->UpdateStats();
     _ClearStats( );
-    assert (_parent->_sim_state == TrafficManager::running);
+    // Workloads move the clear point to their start, which must be after
+    // the warm-up; otherwise it is cycle 0 of every simulation.
+    assert (!gSwm || (_parent->_sim_state == TrafficManager::running));
   }
 
   Flit * flit = NULL;
@@ -1228,6 +1265,22 @@ Flit * EndPoint::inject_flit(BufferState * const dest_buf) {
   // The flit received here should be a transmit flit, not the copy in the OPB.
 
   Flit * flit = NULL;
+  if (_use_crediting && !_flits_waiting_to_inject.empty()) {
+    // Hold the next flit back until the router's input buffer can take it:
+    // a head flit needs its VC released (by the tail credit when
+    // wait_for_tail_credit is set), any flit needs a free slot.
+    Flit * const next = _flits_waiting_to_inject.front().flit;
+    int vc;
+    if (next->head) {
+      find_available_output_vc_for_packet(next);
+      vc = next->vc;
+    } else {
+      vc = _last_vc[next->subnetwork][next->cl];
+    }
+    if ((next->head && !dest_buf->IsAvailableFor(vc)) || dest_buf->IsFullFor(vc)) {
+      return NULL;
+    }
+  }
   if ((!_flits_waiting_to_inject.empty()) &&
       _flits_waiting_to_inject.front().time <= _cur_time) {
 
@@ -1529,7 +1582,7 @@ Flit * EndPoint::find_flit_to_retransmit(BufferState * const dest_buf) {
       cf->itime = _cur_time;
       cf->expire_time = _cur_time + _retry_timer_timeout;
       if (cf->head) {
-        _retry_timer_expiration_queue.push_back({_cur_time + _retry_timer_timeout, cf->dest, cf->packet_seq_num});
+        _retry_timer_expiration_queue.Schedule(_cur_time + _retry_timer_timeout, cf->dest, cf->packet_seq_num);
       }
 
 
@@ -1714,29 +1767,26 @@ Flit * EndPoint::find_timed_out_flit_to_retransmit(BufferState * const dest_buf)
 
   bool from_retry_timer = false;
   bool from_response_timer = false;
-  int cached_time = 0;
+  int64_t cached_time = 0;
   // If a retransmit is already in progress, continue it.
   if (_timedout_packet_retransmit_in_progress.seq_num != -1) {
     dest = _timedout_packet_retransmit_in_progress.dest;
     retry_seq_num = _timedout_packet_retransmit_in_progress.seq_num;
   }
   else {
-    // Check the head of the retry timer queue to see if any packets have
-    // timed out.
-    if ((!_retry_timer_expiration_queue.empty()) && (_retry_timer_expiration_queue.front().time <= _cur_time)) {
-      dest = _retry_timer_expiration_queue.front().dest;
-      retry_seq_num = _retry_timer_expiration_queue.front().seq_num;
-      _retry_timer_expiration_queue.pop_front();
-
-      // For roll back for mypolicy
+    // Check the retry timers, then the response timers, to see if any
+    // packets have timed out.
+    TimerWheel::Timer expired;
+    if (_retry_timer_expiration_queue.PopExpired(_cur_time, expired)) {
       from_retry_timer = true;
-      cached_time = _retry_timer_expiration_queue.front().time;
-    } else if ((!_response_timer_expiration_queue.empty()) && (_response_timer_expiration_queue.front().time <= _cur_time)) {
-      dest = _response_timer_expiration_queue.front().dest;
-      retry_seq_num = _response_timer_expiration_queue.front().seq_num;
-      _response_timer_expiration_queue.pop_front();
+    } else if (_response_timer_expiration_queue.PopExpired(_cur_time, expired)) {
       from_response_timer = true;
-      cached_time = _response_timer_expiration_queue.front().time;
+    }
+    if (from_retry_timer || from_response_timer) {
+      dest = expired.dest;
+      retry_seq_num = expired.seq_num;
+      // For roll back for mypolicy
+      cached_time = expired.time;
     }
   }
 
@@ -1796,9 +1846,9 @@ Flit * EndPoint::find_timed_out_flit_to_retransmit(BufferState * const dest_buf)
                     !(_mypolicy_connections[cf->dest].send_allowance_counter_size > cf->size) &&
                     !_mypolicy_connections[cf->dest].must_retry_at_least_one_packet){
                   if (from_retry_timer){
-                    _retry_timer_expiration_queue.push_front({cached_time, dest, retry_seq_num});
+                    _retry_timer_expiration_queue.Schedule(cached_time, dest, retry_seq_num);
                   } else if(from_response_timer){
-                    _response_timer_expiration_queue.push_front({cached_time, dest, retry_seq_num});
+                    _response_timer_expiration_queue.Schedule(cached_time, dest, retry_seq_num);
                   }
                   return NULL;
                 }
@@ -1857,7 +1907,7 @@ Flit * EndPoint::find_timed_out_flit_to_retransmit(BufferState * const dest_buf)
 
             if (cf->head) {
               // Only push packets (head flits) onto the timer expiration queue.
-              _retry_timer_expiration_queue.push_back({_cur_time + _retry_timer_timeout, cf->dest, cf->packet_seq_num});
+              _retry_timer_expiration_queue.Schedule(_cur_time + _retry_timer_timeout, cf->dest, cf->packet_seq_num);
               _parent->_packet_retransmissions++;
 
               if (cf->transmit_attempts > _max_retry_attempts) {
@@ -2748,7 +2798,7 @@ cout << _cur_time << ": " << Name() << ": Sending RGET_REQUEST to " << flit->des
 
 
     unsigned int opb_hash = get_opb_hash(flit->dest, flit->packet_seq_num);
-    if (_opb_occupancy_map.count(opb_hash) == 0) {
+    if (_opb_occupancy_map[opb_hash] == 0) {
       _opb_occupancy_map[opb_hash] = 1;
     } else {
       assert(_opb_occupancy_map[opb_hash] < _opb_ways);
@@ -2775,7 +2825,7 @@ cout << _cur_time << ": " << Name() << ": Sending RGET_REQUEST to " << flit->des
   opb_flit_copy->expire_time = _cur_time + _retry_timer_timeout;
   // Only push packets onto the timer expiration queue.
   if (opb_flit_copy->head) {
-    _retry_timer_expiration_queue.push_back({_cur_time + _retry_timer_timeout, opb_flit_copy->dest, opb_flit_copy->packet_seq_num});
+    _retry_timer_expiration_queue.Schedule(_cur_time + _retry_timer_timeout, opb_flit_copy->dest, opb_flit_copy->packet_seq_num);
   }
 
   _outstanding_packet_buffer[opb_flit_copy->dest].push_back(opb_flit_copy);
@@ -3159,6 +3209,8 @@ void EndPoint::find_available_output_vc_for_packet(Flit * cf) {
 
 
 void EndPoint::_ReceiveFlit(int subnet, Flit * flit) {
+  PROFILE_PHASE( ENDPOINT_RECEIVE );
+  RandomStreamScope random_scope(&_random);
   if (flit->watch) {
     *gWatchOut << _cur_time << " | "
                << Name() << " | "
@@ -4442,9 +4494,10 @@ unsigned int EndPoint::check_and_clear_opb_of_packet_by_index(int target, unsign
         // We know this is a head flit from the assert above.
         _outstanding_xactions_all_dests_stat--;  // Stat only
         _outstanding_outbound_data_all_dests_stat -= flit->size;  // Stat only
-        _response_timer_expiration_queue.push_back({_cur_time + _response_timer_timeout,
-                                                    flit->dest,
-                                                    flit->packet_seq_num});
+        _retry_timer_expiration_queue.Cancel(flit->dest, flit->packet_seq_num);
+        _response_timer_expiration_queue.Schedule(_cur_time + _response_timer_timeout,
+                                                  flit->dest,
+                                                  flit->packet_seq_num);
         while (opb_idx < _outstanding_packet_buffer[target].size()) {
           flit = _outstanding_packet_buffer[target][opb_idx];
           flit->ack_received = true;
@@ -4462,9 +4515,10 @@ unsigned int EndPoint::check_and_clear_opb_of_packet_by_index(int target, unsign
       incr_amt = packet_size;
     } else if ((flit->type == Flit::RGET_REQUEST) && (!flit->ack_received)) {
 
-      _response_timer_expiration_queue.push_back({_cur_time + _rget_req_pull_timeout,
-                                                  flit->dest,
-                                                  flit->packet_seq_num});
+      _retry_timer_expiration_queue.Cancel(flit->dest, flit->packet_seq_num);
+      _response_timer_expiration_queue.Schedule(_cur_time + _rget_req_pull_timeout,
+                                                flit->dest,
+                                                flit->packet_seq_num);
 
       while (opb_idx < _outstanding_packet_buffer[target].size()) {
         flit = _outstanding_packet_buffer[target][opb_idx];
@@ -4588,6 +4642,8 @@ void EndPoint::clear_opb_of_packet_by_index(const int target, const unsigned int
 
   clear_opb_of_flit_by_index(target, opb_idx);
 
+  _retry_timer_expiration_queue.Cancel(target, clearing_seq_num);
+  _response_timer_expiration_queue.Cancel(target, clearing_seq_num);
 
   if ((type == Flit::WRITE_REQUEST) || (type == Flit::WRITE_REQUEST_NOOP) || (type == Flit::ANY_TYPE)) {
     _outstanding_xactions_per_dest[target]--;
@@ -4671,7 +4727,6 @@ void EndPoint::clear_opb_of_packet_by_index(const int target, const unsigned int
   _opb_pkt_occupancy--;
 
   unsigned int opb_hash = get_opb_hash(target, clearing_seq_num);
-  assert(_opb_occupancy_map.count(opb_hash) > 0);
   assert(_opb_occupancy_map[opb_hash] > 0);
   _opb_occupancy_map[opb_hash]--;
 }
@@ -4801,6 +4856,8 @@ void EndPoint::_ReceiveCredit(int subnet, Credit * cred) {
 
 
 Credit * EndPoint::_ProcessReceivedFlits(int subnet, Flit * & received_flit_ptr) {
+  PROFILE_PHASE( ENDPOINT_PROCESS );
+  RandomStreamScope random_scope(&_random);
   Credit * cred = NULL;
 
   // Add logic here to decide when to return a credit.
@@ -4894,7 +4951,6 @@ Credit * EndPoint::_ProcessReceivedFlits(int subnet, Flit * & received_flit_ptr)
         exit(1);
       } else {
 
-        assert(_mypolicy_endpoint.latency->_need_percentile);
         double tmp = _cur_time - received_flit_ptr->ctime;
         if (received_flit_ptr->ctime >= _parent->_reset_time){
             _mypolicy_endpoint.latency->AddSample(tmp);
@@ -5892,11 +5948,9 @@ bool EndPoint::_EndPointProcessingFinished(){
 
 
 bool EndPoint::_OPBDrained() {
-  map<int, deque< Flit * > >::iterator dest_iter;
-  for ( dest_iter = _outstanding_packet_buffer.begin();
-        dest_iter != _outstanding_packet_buffer.end();
-        dest_iter++ ) {
-    if ( !_outstanding_packet_buffer[dest_iter->first].empty() ) {
+  for ( size_t dest = 0; dest < _outstanding_packet_buffer.keys(); dest++ ) {
+    if ( _outstanding_packet_buffer.count(dest) &&
+         !_outstanding_packet_buffer[dest].empty() ) {
       return false;
     }
   }
@@ -5946,6 +6000,143 @@ bool EndPoint::_AcksToReturn() {
 }
 
 
+int64_t EndPoint::_NextEventTime() {
+  int64_t const now = _parent->_time;
+
+  // Anything in progress or queued up keeps the endpoint busy.
+  if ((_new_packet_transmission_in_progress != NULL_Q) ||
+      (_timedout_packet_retransmit_in_progress.seq_num != -1) ||
+      !_pending_nack_replays.empty() ||
+      !_flits_waiting_to_inject.empty() ||
+      (_num_flits_waiting_to_inject >= _max_flits_waiting_to_inject) ||
+      (_opb_pkt_occupancy != 0) ||
+      (_opb_pkt_occupancy >= _opb_max_pkt_occupancy) ||
+      !_received_ack_queue.empty() ||
+      !_pending_inbound_response_queue.empty() ||
+      !_pending_outbound_response_queue.empty() ||
+      !_put_buffer_meta.queue.empty() ||
+      !_mypolicy_endpoint.ack_queue.empty() ||
+      (_tx_arb_mode != ROUND_ROBIN) ||
+      _debug_enabled || _trace_debug) {
+    return now;
+  }
+  for (int subnet = 0; subnet < _subnets; ++subnet) {
+    if (!_incoming_flit_queue[subnet].empty()) {
+      return now;
+    }
+  }
+
+  int64_t next = INT64_MAX;
+
+  if (!_parent->_empty_network) {
+    if (!gSwm && (_parent->_intended_load[0][_nodeid] == (double)1.0)) {
+      return now;
+    }
+    for (int c = 0; c < _classes; ++c) {
+      // _qtime lagging behind means generation still has to catch up.
+      if (_qtime[c] < now) {
+        return now;
+      }
+      next = min(next, _parent->_injection_process[c]->ready_time(_nodeid));
+    }
+  }
+
+  next = min(next, _retry_timer_expiration_queue.NextExpiry());
+  next = min(next, _response_timer_expiration_queue.NextExpiry());
+  next = min(next, (int64_t)_mypolicy_endpoint.next_change_bandwidth_time);
+  if (_mypolicy_constant.policy == HC_ECN_POLICY) {
+    next = min(next, (int64_t)_mypolicy_endpoint.ecn_next_check_period + 1);
+  }
+
+  // Adaptive RGET conversion samples and the stats clear happen at fixed cycles.
+  int64_t const sample_from = max(now, (int64_t)1);
+  next = min(next, ((sample_from + _rget_convert_sample_period - 1) / _rget_convert_sample_period) *
+                   _rget_convert_sample_period);
+  if (gLastClearStatTime >= now) {
+    next = min(next, (int64_t)gLastClearStatTime);
+  }
+
+  return max(next, now);
+}
+
+
+int64_t EndPoint::_NextPerDestEventTime() {
+  int64_t const now = _parent->_time;
+
+  for (int c = 0; c < _classes; ++c) {
+    if (!InjectionBuffersEmpty(c)) {
+      return now;
+    }
+  }
+  if (!PendingRepliesDrained() || !PendingRgetGetRequestQueuesDrained()) {
+    return now;
+  }
+
+  int64_t next = INT64_MAX;
+  for (unsigned int initiator = 0; initiator < _endpoints; initiator++) {
+    ack_response_record const & ack_state = _ack_response_state[initiator];
+    mypolicy_host_control_connection_record const & hc_state = _mypolicy_connections[initiator];
+
+    if ((ack_state.outstanding_ack_type_to_return == ACK) ||
+        (ack_state.outstanding_ack_type_to_return == NACK) ||
+        (ack_state.outstanding_ack_type_to_return == SACK)) {
+      // Same conditions as manufacture_standalone_ack.
+      if ((ack_state.packets_recvd_since_last_ack >= _packets_before_standalone_ack) ||
+          hc_state.speculative_ack_allowance_size) {
+        return now;
+      }
+      next = min(next, (int64_t)ack_state.time_last_valid_unacked_packet_recvd +
+                       _cycles_before_standalone_ack);
+      if (hc_state.earliest_accum_ack_shared_time != -1) {
+        next = min(next, (int64_t)hc_state.earliest_accum_ack_shared_time +
+                         _mypolicy_constant.time_before_shared_ack_timeout + 1);
+      }
+    }
+
+    // Host control halt timeout (process_received_ack_queue).
+    if ((_mypolicy_constant.policy == HC_MY_POLICY) && hc_state.halt_active) {
+      next = min(next, (int64_t)hc_state.time_last_ack_recvd +
+                       _mypolicy_constant.time_before_halt_state_timeout);
+    }
+  }
+
+  return max(next, now);
+}
+
+
+void EndPoint::_SkipIdleCycles(int64_t cycles) {
+  int64_t const now = _parent->_time;
+  bool const running = (_parent->_sim_state == TrafficManager::running);
+
+  // _EvaluateNewPacketInjection: the injection process declines once per cycle.
+  if (!_parent->_empty_network) {
+    for (int c = 0; c < _classes; ++c) {
+      _parent->_injection_process[c]->skip(_nodeid, cycles);
+      _qtime[c] += cycles;
+      if ((_parent->_sim_state == TrafficManager::draining) &&
+          (_qtime[c] > _parent->_drain_time)) {
+        _qdrained[c] = true;
+      }
+    }
+    if (running) {
+      _cycles_generation_not_attempted += cycles;
+    }
+  }
+
+  // _Step, once per subnet: either blocked by the packet processing penalty,
+  // or the link was available but there was nothing to send.
+  if (running) {
+    int64_t blocked = (int64_t)_next_packet_injection_blocked_until - now;
+    blocked = max((int64_t)0, min(blocked, cycles));
+    _cycles_new_flit_not_injected += cycles * _subnets;
+    _cycles_new_flit_not_injected_due_to_packet_processing_penalty += blocked * _subnets;
+    _cycles_link_avail_no_new_flits += (cycles - blocked) * _subnets;
+  }
+
+  _cur_time = now + cycles - 1;
+}
+
+
 void EndPoint::_ClearStats(){
   _parent->_ClearStats();
 
@@ -5991,7 +6182,227 @@ void EndPoint::_ClearStats(){
   CLEAR(_new_sent_packets);
   CLEAR(_received_flits);
   CLEAR(_received_packets);
+  _sent_data_flits = 0;
+  _new_sent_data_flits = 0;
+  _received_data_flits = 0;
+
+}
 
+void EndPoint::Checkpoint(CheckpointFile & cp) {
+  cp.Check(FullName() + " endpoints", _endpoints);
+  cp.Check(FullName() + " subnets", _subnets);
+
+  cp.Io(_cur_time);
+  if (gRandomStreams) {
+    cp.Io(_random.Counter());
+  }
+  cp.Io(_opb_pkt_occupancy);
+  cp.Io(_new_packet_transmission_in_progress);
+  cp.Io(_next_packet_injection_blocked_until);
+  cp.Io(_num_flits_waiting_to_inject);
+  cp.Io(_flits_waiting_to_inject);
+
+  cp.Io(_qtime);
+  cp.Io(_qdrained);
+  cp.Io(_injection_buffer);
+  cp.Io(_full_packets_in_inj_buf);
+  cp.Io(_generated_packets);
+  cp.Io(_generated_packets_full_sim);
+  cp.Io(_generated_flits);
+  cp.Io(_generated_flits_full_sim);
+  cp.Io(_injected_flits);
+  cp.Io(_sent_flits);
+  cp.Io(_sent_packets);
+  cp.Io(_sent_data_flits);
+  cp.Io(_new_sent_flits);
+  cp.Io(_new_sent_packets);
+  cp.Io(_new_sent_data_flits);
+  cp.Io(_received_flits);
+  cp.Io(_received_packets);
+  cp.Io(_received_data_flits);
+  cp.Io(_last_class);
+  cp.Io(_last_vc);
+
+  for (int s = 0; s < _subnets; ++s) {
+    _buf_states[s]->Checkpoint(cp);
+  }
+  cp.Io(_incoming_flit_queue);
+  cp.Io(_repliesPending);
+  cp.Io(_rget_get_req_queues);
+
+  cp.Io(_packet_seq_num);
+  cp.Io(_recvd_seq_num_vec);
+  cp.Io(_inj_buf_rr_idx);
+  cp.Io(_rsp_buf_rr_idx);
+  cp.Io(_rget_get_req_buf_rr_idx);
+  cp.Io(_tx_queue_type_rr_selector);
+  cp.Io(_weighted_sched_queue_tokens);
+  _retry_timer_expiration_queue.Checkpoint(cp);
+  _response_timer_expiration_queue.Checkpoint(cp);
+
+  if (!cp.IsSaving()) {
+    _outstanding_packet_buffer.reset(_endpoints);
+  }
+  for (size_t dest = 0; dest < _outstanding_packet_buffer.keys(); ++dest) {
+    bool present = _outstanding_packet_buffer.count(dest);
+    cp.Io(present);
+    if (present) {
+      cp.Io(_outstanding_packet_buffer[dest]);
+    }
+  }
+
+  cp.Io(_outstanding_xactions_per_dest);
+  cp.Io(_outstanding_put_data_per_dest);
+  cp.Io(_outstanding_put_data_samples_per_dest);
+  cp.Io(_new_write_ack_data_per_dest);
+  cp.Io(_new_write_ack_data_samples_per_dest);
+  cp.Io(_periods_since_last_transition);
+  cp.Io(_converting_puts_to_rgets);
+  cp.Io(_outstanding_xactions_all_dests_stat);
+  cp.Io(_outstanding_gets_per_dest);
+  cp.Io(_outstanding_rget_reqs_per_dest);
+  cp.Io(_outstanding_outbound_data_per_dest);
+  cp.Io(_outstanding_outbound_data_all_dests_stat);
+  cp.Io(_outstanding_inbound_data_per_dest);
+  cp.Io(_outstanding_rget_inbound_data_per_dest);
+  cp.Io(_outstanding_global_get_requests);
+  cp.Io(_outstanding_global_get_req_inbound_data);
+  cp.Io(_opb_occupancy_map);
+
+  cp.Io(_packet_gen_attempts);
+  cp.Io(_opb_insertion_conflicts);
+  cp.Io(_req_inj_blocked_on_xaction_limit);
+  cp.Io(_req_inj_blocked_on_size_limit);
+  cp.Io(_req_inj_blocked_on_ws_tokens);
+  cp.Io(_read_req_inj_blocked_on_xaction_limit);
+  cp.Io(_read_req_inj_blocked_on_size_limit);
+  cp.Io(_resp_inj_blocked_on_xaction_limit);
+  cp.Io(_resp_inj_blocked_on_size_limit);
+  cp.Io(_resp_inj_blocked_on_ws_tokens);
+  cp.Io(_rget_req_inj_blocked_on_xaction_limit);
+  cp.Io(_rget_req_inj_blocked_on_rget_req_limit);
+  cp.Io(_rget_req_inj_blocked_on_size_limit);
+  cp.Io(_rget_req_inj_blocked_on_inbound_data_limit);
+  cp.Io(_rget_get_req_inj_blocked_on_get_limit);
+  cp.Io(_rget_get_req_inj_blocked_on_inbound_data_limit);
+  cp.Io(_rget_get_req_inj_blocked_on_ws_tokens);
+  cp.Io(_rget_get_req_inj_blocked_on_global_request_limit);
+  cp.Io(_rget_get_req_inj_blocked_on_global_get_data_limit);
+  cp.Io(_get_req_inj_blocked_on_global_request_limit);
+  cp.Io(_get_req_inj_blocked_on_global_get_data_limit);
+
+  cp.Io(_packets_retired);
+  cp.Io(_packets_retired_full_sim);
+  cp.Io(_flits_retired);
+  cp.Io(_flits_retired_full_sim);
+  cp.Io(_data_flits_retired);
+  cp.Io(_data_flits_retired_full_sim);
+  cp.Io(_retry_timeouts);
+  cp.Io(_good_packets_received);
+  cp.Io(_good_packets_write_received);
+  cp.Io(_good_flits_received);
+  cp.Io(_good_data_flits_received);
+  cp.Io(_good_packets_received_full_sim);
+  cp.Io(_good_flits_received_full_sim);
+  cp.Io(_good_data_flits_received_full_sim);
+  cp.Io(_duplicate_packets_received);
+  cp.Io(_duplicate_flits_received);
+  cp.Io(_duplicate_packets_received_full_sim);
+  cp.Io(_duplicate_flits_received_full_sim);
+  cp.Io(_bad_packets_received);
+  cp.Io(_bad_flits_received);
+  cp.Io(_bad_packets_received_full_sim);
+  cp.Io(_bad_flits_received_full_sim);
+  cp.Io(_flits_dropped_for_rget_conversion);
+  cp.Io(_packets_dequeued);
+
+  cp.Io(_timedout_packet_retransmit_in_progress);
+  cp.Io(_retry_state_tracker);
+  cp.Io(_pending_nack_replays);
+  cp.Io(_received_ack_queue);
+  cp.Io(_pending_inbound_response_queue);
+  cp.Io(_pending_outbound_response_queue);
+
+  cp.Check(FullName() + " host control policy", _mypolicy_constant.policy);
+  cp.Io(_mypolicy_connections);
+
+  mypolicy_host_control_endpoint_record & ep = _mypolicy_endpoint;
+  cp.Io(ep.ack_queue);
+  cp.Io(ep.speculative_ack_queue);
+  cp.Io(ep.acked_data_in_queue);
+  cp.Io(ep.data_dequeued_but_need_acked);
+  cp.Io(ep.num_initiator_retransmitting);
+  cp.Io(ep.host_congestion_enabled);
+  cp.Io(ep.max_ratio_valid);
+  cp.Io(ep.max_occupancy_src);
+  cp.Io(ep.periodic_total_occupancy);
+  cp.Io(ep.total_packet_occupy);
+  cp.Io(ep.next_fairness_request_time);
+  cp.Io(ep.next_fairness_reset_time);
+  cp.Io(ep.suppress_request);
+  cp.Io(ep.suppress_target);
+  cp.Io(ep.suppress_active);
+  cp.Io(ep.reserved_space);
+  cp.Io(ep.current_host_bandwith);
+  cp.Io(ep.next_change_host_bandwdith_time);
+  cp.Io(ep.next_change_bandwidth_time);
+  cp.Io(ep.host_bandwidth_is_slow);
+  cp.Io(ep.ecn_next_check_period);
+  // The standard library only exposes engine and distribution state as text.
+  ostringstream random_state;
+  random_state.precision(numeric_limits<double>::max_digits10);
+  random_state << ep.generator << ' ' << *ep.interarrival_logn;
+  string random_text = random_state.str();
+  cp.Io(random_text);
+  if (!cp.IsSaving()) {
+    istringstream restored(random_text);
+    restored >> ep.generator >> *ep.interarrival_logn;
+  }
+  ep.latency->Checkpoint(cp);
+
+  put_buffer_metadata & meta = _put_buffer_meta;
+  cp.Check(FullName() + " put buffer size", meta.queue_size);
+  cp.Check(FullName() + " load balance buffer size", meta.load_balance_queue_size);
+  cp.Io(meta.queue);
+  cp.Io(meta.load_balance_queue);
+  cp.Io(meta.slow);
+  cp.Io(meta.remaining);
+  cp.Io(meta.load_balance_queue_remaining);
+  cp.Io(meta.latency_length_remaining);
+  cp.Io(meta.left_over_cycle_saving_from_previous_packet);
+  cp.Io(meta.next_bursty_time);
+  cp.Io(meta.packet_dropped);
+  cp.Io(meta.packet_dropped_full);
+
+  cp.Io(_incoming_packet_src);
+  cp.Io(_incoming_packet_pid);
+  cp.Io(_incoming_packet_seq);
+  cp.Io(_incoming_packet_flit_countdown);
+  cp.Io(_incoming_packet_flit_total);
+  cp.Io(_ack_response_state);
+
+  cp.Io(_cycles_generation_not_attempted);
+  cp.Io(_cycles_gen_attempted_but_blocked);
+  cp.Io(_cycles_new_flit_not_injected);
+  cp.Io(_cycles_new_flit_not_injected_due_to_packet_processing_penalty);
+  cp.Io(_cycles_new_flit_not_injected_due_to_staging_buffer_full);
+  cp.Io(_cycles_inj_present_but_blocked);
+  cp.Io(_cycles_link_avail_no_new_flits);
+  cp.Io(_cycles_retransmitting);
+  cp.Io(_packets_retransmitted);
+  cp.Io(_packets_retransmitted_full_sim);
+  cp.Io(_flits_retransmitted_full_sim);
+  cp.Io(_max_packet_retries_full_sim);
+  cp.Io(_cycles_inj_all_blocked_on_timeout);
+  cp.Io(_max_outstanding_xactions_per_dest_stat);
+  cp.Io(_max_outstanding_xactions_all_dests_stat);
+  cp.Io(_max_total_outstanding_data_per_dest_stat);
+  cp.Io(_max_total_outstanding_outbound_data_all_dests_stat);
+  cp.Io(_nacks_sent);
+  cp.Io(_nacks_received);
+  cp.Io(_sacks_sent);
+  cp.Io(_sacks_received);
+  cp.Io(_puts_converted_to_rgets);
 }
 
 bool EndPoint::_EndSimulation() {
@@ -6109,8 +6520,6 @@ bool EndPoint::_EndSimulation() {
     }
   }
 
-  assert(_mypolicy_endpoint.latency->_need_percentile);
-
   // Stats from TM do no include startup and drain phases
   double time_delta = (double)(_parent->_drain_time - _parent->_reset_time);
   int cl = 0;
@@ -6266,13 +6675,10 @@ void EndPoint::DumpOPB() {
   cout << "  Dest:  Retry State, Retry Index :   Seq Num: Flits" << endl;
 
   // Iterate over all keys (dest ids) in the OPB.
-  map<int, deque< Flit * > >::iterator dest_iter;
-  deque<Flit *>::iterator flit_iter;
-  for ( dest_iter = _outstanding_packet_buffer.begin();
-        dest_iter != _outstanding_packet_buffer.end();
-        dest_iter++ ) {
-    // dest_iter->first is the dest id
-    DumpOPB(dest_iter->first);
+  for ( size_t dest = 0; dest < _outstanding_packet_buffer.keys(); dest++ ) {
+    if ( _outstanding_packet_buffer.count(dest) ) {
+      DumpOPB(dest);
+    }
   }
 }
 
@@ -6383,11 +6789,8 @@ void EndPoint::DumpRgetGetRequestQueues() {
 void EndPoint::DumpPacketSequenceTracker() {
   cout << _cur_time << ": " << Name() << ": Packet sequence number" << endl;
   cout << "  Dest  |  CurNum" << endl;
-  map<int, int>::iterator dest_iter;
-  for ( dest_iter = _packet_seq_num.begin();
-        dest_iter != _packet_seq_num.end();
-        dest_iter++ ) {
-    cout << "      " << dest_iter->first << "  |  " << dest_iter->second << endl;
+  for ( size_t dest = 0; dest < _packet_seq_num.size(); dest++ ) {
+    cout << "      " << dest << "  |  " << _packet_seq_num[dest] << endl;
   }
 }
 
@@ -12,6 +12,9 @@
 #include "packet_reply_info.hpp"
 #include "random_utils.hpp"
 #include "wkld_msg.hpp"
+#include "dense_map.hpp"
+#include "checkpoint.hpp"
+#include "timer_wheel.hpp"
 
 
 // EndPoints function as both the initiator of transactions and the receiver.
@@ -23,6 +26,9 @@ private:
   TrafficManager * _parent;
   int _cur_time;
 
+  // draws made while the endpoint is evaluated, with random_streams
+  RandomStream _random;
+
   unsigned int _endpoints;
   int _subnets;
   int _classes;
@@ -71,6 +77,11 @@ private:
     Flit * flit;
     int time;
     bool new_flit;
+    void Checkpoint(CheckpointFile & cp) {
+      cp.Io(flit);
+      cp.Io(time);
+      cp.Io(new_flit);
+    }
   };
   queue< flit_time_pair > _flits_waiting_to_inject;
 
@@ -120,8 +131,8 @@ private:
   // ********************* Tracking of packet transmission *********************
   // Vectored by dest
   // An endpoint must keep sequence numbers separate for each dest.
-  map<int, int> _packet_seq_num;
-  map<int, int> _recvd_seq_num_vec;
+  vector<int> _packet_seq_num;
+  vector<int> _recvd_seq_num_vec;
   // Temporary storage for packets that have been "moved aside" from the main
   // _injection_buffer because the target was in the middle of a retry.
   // This structure only needs to hold a maximum of one packet per dest because
@@ -150,27 +161,24 @@ private:
   int _weighted_sched_rsp_slots_per_req_slot;
   bool _debug_ws;
 
-  struct timer_struct {
-    int time;
-    int dest;
-    int seq_num;
-  };
-  list<timer_struct> _retry_timer_expiration_queue;
-  list<timer_struct> _response_timer_expiration_queue;
+  // Retry timers of unacked packets and response timers of acked reads,
+  // keyed by (dest, packet_seq_num) and cancelled when the packet retires.
+  TimerWheel _retry_timer_expiration_queue;
+  TimerWheel _response_timer_expiration_queue;
 
 
   // For E2E reliability.  Hold packets here until an ack is received.
   // Outer structure is for each destination.
   // Middle is for each packet.
   // Inner is the list of flits in the packet.
-  map<int, deque< Flit * > > _outstanding_packet_buffer;
-
-  map<int, unsigned int> _outstanding_xactions_per_dest;      // RATE_LIMIT.reliable_pkts
-  map<int, unsigned int> _outstanding_put_data_per_dest;
-  map<int, deque<unsigned int> > _outstanding_put_data_samples_per_dest;
-  map<int, unsigned int> _new_write_ack_data_per_dest;
-  map<int, deque<int> > _new_write_ack_data_samples_per_dest;
-  map<int, unsigned int> _periods_since_last_transition;
+  DenseMap< deque< Flit * > > _outstanding_packet_buffer;
+
+  vector<unsigned int> _outstanding_xactions_per_dest;      // RATE_LIMIT.reliable_pkts
+  vector<unsigned int> _outstanding_put_data_per_dest;
+  vector< deque<unsigned int> > _outstanding_put_data_samples_per_dest;
+  vector<unsigned int> _new_write_ack_data_per_dest;
+  vector< deque<int> > _new_write_ack_data_samples_per_dest;
+  vector<unsigned int> _periods_since_last_transition;
   int _enable_adaptive_rget;
   int _rget_convert_sample_period;
   float _rget_convert_unacked_perc;
@@ -178,19 +186,19 @@ private:
   unsigned int _rget_convert_num_samples;
   unsigned int _rget_min_samples_since_last_transition;
   unsigned int _rget_convert_min_data_before_convert;
-  map<unsigned int, bool>         _converting_puts_to_rgets;
+  vector<bool>                    _converting_puts_to_rgets;
   unsigned int _outstanding_xactions_all_dests_stat;
-  map<unsigned int, unsigned int> _outstanding_gets_per_dest;          // GET_RATE_LIMIT.outstanding_pkts
-  map<unsigned int, unsigned int> _outstanding_rget_reqs_per_dest;     // RGET.pkt_credit
-  map<unsigned int, unsigned int> _outstanding_outbound_data_per_dest; // RATE_LIMIT.reliable_size
+  vector<unsigned int>            _outstanding_gets_per_dest;          // GET_RATE_LIMIT.outstanding_pkts
+  vector<unsigned int>            _outstanding_rget_reqs_per_dest;     // RGET.pkt_credit
+  vector<unsigned int>            _outstanding_outbound_data_per_dest; // RATE_LIMIT.reliable_size
   unsigned int _outstanding_outbound_data_all_dests_stat;
-  map<unsigned int, unsigned int> _outstanding_inbound_data_per_dest;  // GET_RATE_LIMIT.outstanding_pkts
-  map<unsigned int, unsigned int> _outstanding_rget_inbound_data_per_dest;  // RGET.data_credit
+  vector<unsigned int>            _outstanding_inbound_data_per_dest;  // GET_RATE_LIMIT.outstanding_pkts
+  vector<unsigned int>            _outstanding_rget_inbound_data_per_dest;  // RGET.data_credit
 
   unsigned int _outstanding_global_get_requests;          // GLOBAL_GET_RATE_LIMIT.outstd_pkts
   unsigned int _outstanding_global_get_req_inbound_data;  // GLOBAL_GET_RATE_LIMIT.outstd_data
 
-  map<unsigned int, unsigned int> _opb_occupancy_map;
+  vector<unsigned int> _opb_occupancy_map;
   unsigned int _opb_ways;
   unsigned int _opb_dest_idx_mask;
   unsigned int _opb_seq_num_idx_mask;
@@ -270,7 +278,7 @@ private:
     int seq_num;
   };
   retrans_record _timedout_packet_retransmit_in_progress;
-  map<unsigned int, dest_retry_record> _retry_state_tracker;
+  vector<dest_retry_record> _retry_state_tracker;
   // Need to store all nacks received that have not yet been serviced
   deque<int> _pending_nack_replays;
 
@@ -298,6 +306,20 @@ private:
     int rget_data_size;
     WorkloadMessagePtr data;
     bool watch;
+    void Checkpoint(CheckpointFile & cp) {
+      if (data) {
+        cp.Error("pending response carries a workload message");
+      }
+      cp.Io(source);
+      cp.Io(type);
+      cp.Io(reply_size);
+      cp.Io(time);
+      cp.Io(record);
+      cp.Io(cl);
+      cp.Io(req_seq_num);
+      cp.Io(rget_data_size);
+      cp.Io(watch);
+    }
   };
   deque<pending_rsp_record> _pending_inbound_response_queue;
   deque<pending_rsp_record> _pending_outbound_response_queue;
@@ -309,10 +331,21 @@ private:
     int src;
     double remaining_process_size;
     Flit * homa_flit;
+    void Checkpoint(CheckpointFile & cp) {
+      cp.Io(pid);
+      cp.Io(size);
+      cp.Io(src);
+      cp.Io(remaining_process_size);
+      cp.Io(homa_flit);
+    }
   };
   struct load_balance_queue_record {
     Flit * flit;
     int size;
+    void Checkpoint(CheckpointFile & cp) {
+      cp.Io(flit);
+      cp.Io(size);
+    }
   };
 
 
@@ -533,7 +566,7 @@ private:
     int packet_dropped_full;
   };
 
-  map<unsigned int, mypolicy_host_control_connection_record> _mypolicy_connections;
+  vector<mypolicy_host_control_connection_record> _mypolicy_connections;
   mypolicy_host_control_constant_record _mypolicy_constant;
   mypolicy_host_control_endpoint_record _mypolicy_endpoint;
   put_buffer_metadata _put_buffer_meta;
@@ -587,7 +620,7 @@ private:
     unsigned long sack_vec;
   };
   // Vectored by the message initiator
-  map<unsigned int, ack_response_record> _ack_response_state;
+  vector<ack_response_record> _ack_response_state;
 
 
   // Stats
@@ -647,6 +680,11 @@ public:
       return _put_buffer_meta.queue_size - _put_buffer_meta.remaining;
   }
 
+  // Packets held in the OPB awaiting acknowledgement, and flits
+  // retransmitted since the start of the run.
+  inline unsigned int OPBOccupancy() const { return _opb_pkt_occupancy; }
+  inline unsigned int FlitsRetransmitted() const { return _flits_retransmitted_full_sim; }
+
   inline int lbq_occupied_size() {
       return _put_buffer_meta.load_balance_queue_size - _put_buffer_meta.load_balance_queue_remaining;
   }
@@ -766,6 +804,22 @@ public:
   bool _EndSimulation();
   unsigned int _GetFlitsDroppedForRgetConversion();
 
+  // Saves or restores the dynamic state of the endpoint.  Configuration
+  // derived fields are not saved; they come from the configuration of the
+  // restoring simulator.
+  void Checkpoint(CheckpointFile & cp);
+
+  // Called by TrafficManager to fast-forward over idle cycles.
+  // _NextEventTime returns the current cycle while the endpoint has work to
+  // do, and otherwise the earliest later cycle at which it can act on its
+  // own.  _NextPerDestEventTime does the same for the per-dest queues and
+  // ack state, which cost O(endpoints) to scan.  _SkipIdleCycles accounts
+  // for the skipped cycles exactly as _EvaluateNewPacketInjection and _Step
+  // would have.
+  int64_t _NextEventTime();
+  int64_t _NextPerDestEventTime();
+  void _SkipIdleCycles(int64_t cycles);
+
   bool InjectionBuffersEmpty(int c);
   bool InjectionBuffersNotEmptyButAllBlockedOnTimeout(int c);
   bool PendingRepliesDrained();
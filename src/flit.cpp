@@ -34,11 +34,18 @@
  *When adding objects make sure to set a default value in this constructor
  */
 
+#include <cassert>
+#include <new>
+
 #include "booksim.hpp"
 #include "flit.hpp"
+#include "checkpoint.hpp"
 
-stack<Flit *> Flit::_all;
-stack<Flit *> Flit::_free;
+Flit * Flit::_chunks[Flit::MAX_CHUNKS];
+Flit::Handle Flit::_allocated = 0;
+vector<Flit::Handle> Flit::_free;
+bool Flit::_thread_safe = false;
+mutex Flit::_lock;
 
 ostream& operator<<( ostream& os, const Flit& f )
 {
@@ -136,25 +143,105 @@ void Flit::copy_target(Flit * flit) {
 }
 
 Flit * Flit::New() {
+  unique_lock<mutex> guard(_lock, defer_lock);
+  if(_thread_safe) {
+    guard.lock();
+  }
   Flit * f;
   if(_free.empty()) {
-    f = new Flit;
-    _all.push(f);
+    Handle const h = _allocated++;
+    int const chunk = h >> CHUNK_BITS;
+    if((h & CHUNK_MASK) == 0) {
+      assert(chunk < MAX_CHUNKS);
+      _chunks[chunk] = static_cast<Flit *>(::operator new((CHUNK_MASK + 1) * sizeof(Flit)));
+    }
+    f = new (&_chunks[chunk][h & CHUNK_MASK]) Flit;
+    f->_handle = h;
   } else {
-    f = _free.top();
+    f = FromHandle(_free.back());
     f->Reset();
-    _free.pop();
+    _free.pop_back();
   }
   return f;
 }
 
 void Flit::Free() {
-  _free.push(this);
+  unique_lock<mutex> guard(_lock, defer_lock);
+  if(_thread_safe) {
+    guard.lock();
+  }
+  _free.push_back(_handle);
 }
 
 void Flit::FreeAll() {
-  while(!_all.empty()) {
-    delete _all.top();
-    _all.pop();
+  for(Handle h = 0; h < _allocated; ++h) {
+    FromHandle(h)->~Flit();
+  }
+  for(Handle h = 0; h < _allocated; h += CHUNK_MASK + 1) {
+    ::operator delete(_chunks[h >> CHUNK_BITS]);
+    _chunks[h >> CHUNK_BITS] = NULL;
+  }
+  _allocated = 0;
+  _free.clear();
+}
+
+void Flit::Checkpoint(CheckpointFile & cp) {
+  Handle allocated = _allocated;
+  cp.Io(allocated);
+  if(!cp.IsSaving()) {
+    FreeAll();
+    for(Handle h = 0; h < allocated; ++h) {
+      New();
+    }
+  }
+  cp.Io(_free);
+
+  vector<bool> is_free(_allocated, false);
+  for(size_t i = 0; i < _free.size(); ++i) {
+    is_free[_free[i]] = true;
+  }
+  for(Handle h = 0; h < _allocated; ++h) {
+    Flit * const f = FromHandle(h);
+    if(cp.IsSaving() && !is_free[h] && f->data) {
+      cp.Error("flits carrying workload messages cannot be checkpointed");
+    }
+    f->data = 0;
+    cp.Io(f->type);
+    cp.Io(f->vc);
+    cp.Io(f->cl);
+    cp.Io(f->head);
+    cp.Io(f->tail);
+    cp.Io(f->watch);
+    cp.Io(f->record);
+    cp.Io(f->src);
+    cp.Io(f->dest);
+    cp.Io(f->pri);
+    cp.Io(f->hops);
+    cp.Io(f->subnetwork);
+    cp.Io(f->intm);
+    cp.Io(f->ph);
+    cp.Io(f->id);
+    cp.Io(f->pid);
+    cp.Io(f->la_route_set);
+    cp.Io(f->ctime);
+    cp.Io(f->itime);
+    cp.Io(f->first_itime);
+    cp.Io(f->atime);
+    cp.Io(f->debug_dest);
+    cp.Io(f->non_duplicate_ack);
+    cp.Io(f->ecn_congestion_detected);
+    cp.Io(f->size);
+    cp.Io(f->packet_seq_num);
+    cp.Io(f->ack_seq_num);
+    cp.Io(f->nack_seq_num);
+    cp.Io(f->response_to_seq_num);
+    cp.Io(f->transmit_attempts);
+    cp.Io(f->read_requested_data_size);
+    cp.Io(f->ack_received);
+    cp.Io(f->response_received);
+    cp.Io(f->expire_time);
+    cp.Io(f->ack_received_time);
+    cp.Io(f->sack);
+    cp.Io(f->sack_vec);
   }
 }
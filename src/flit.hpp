@@ -29,12 +29,16 @@
 #define _FLIT_HPP_
 
 #include <iostream>
-#include <stack>
+#include <vector>
+#include <mutex>
+#include <stdint.h>
 
 #include "booksim.hpp"
 #include "outputset.hpp"
 #include "wkld_msg.hpp"
 
+class CheckpointFile;
+
 class Flit {
 
 public:
@@ -52,6 +56,8 @@ public:
       WRITE_REQUEST_NOOP = 9,
       NUM_TYPES = 10
   };
+  // Fields read by the routers on every hop come first so that they share
+  // the flit's first cache line.
   FlitType type;
 
   int vc;
@@ -60,27 +66,37 @@ public:
 
   bool head;
   bool tail;
-
-  int64_t  ctime;
-  int64_t  itime;
-  int64_t  first_itime;
-  int64_t  atime;
-
-  int64_t  id;
-  int64_t  pid;
-
+  bool watch;
   bool record;
 
   int  src;
   int  dest;
-  int debug_dest;
 
   int  pri;
 
   int  hops;
-  bool watch;
   int  subnetwork;
 
+  // intermediate destination (if any)
+  mutable int intm;
+
+  // phase in multi-phase algorithms
+  mutable int ph;
+
+  int64_t  id;
+  int64_t  pid;
+
+  // Lookahead route info
+  OutputSet la_route_set;
+
+  // Endpoint, statistics and debug state.
+  int64_t  ctime;
+  int64_t  itime;
+  int64_t  first_itime;
+  int64_t  atime;
+
+  int debug_dest;
+
   bool non_duplicate_ack;
 
   bool ecn_congestion_detected;
@@ -102,25 +118,32 @@ public:
   bool sack;
   unsigned int sack_vec;
 
-  // intermediate destination (if any)
-  mutable int intm;
-
-  // phase in multi-phase algorithms
-  mutable int ph;
-
   // Fields for arbitrary data
   //void* data ;
   WorkloadMessagePtr data; // for swm
 
-  // Lookahead route info
-  OutputSet la_route_set;
-
   void Reset();
 
   static Flit * New();
   void Free();
   static void FreeAll();
 
+  // Flits are carved out of fixed-size chunks and never move, so a flit can
+  // be named by a 32-bit handle (chunk number and slot) instead of a pointer.
+  typedef uint32_t Handle;
+  inline Handle GetHandle() const { return _handle; }
+  static inline Flit * FromHandle(Handle h) {
+    return &_chunks[h >> CHUNK_BITS][h & CHUNK_MASK];
+  }
+
+  // Guard the free list when flits are allocated and released from the
+  // worker threads of the parallel engine.
+  static void SetThreadSafe(bool thread_safe) { _thread_safe = thread_safe; }
+
+  // Saves or restores every flit in the arena, free ones included, so that
+  // handles stay valid across a checkpoint.
+  static void Checkpoint(CheckpointFile & cp);
+
   void copy(Flit * flit);
   void copy_target(Flit * flit);
 
@@ -129,8 +152,18 @@ private:
   Flit();
   ~Flit() {}
 
-  static stack<Flit *> _all;
-  static stack<Flit *> _free;
+  Handle _handle;
+
+  static const int CHUNK_BITS = 12;
+  static const Handle CHUNK_MASK = (1u << CHUNK_BITS) - 1;
+  static const int MAX_CHUNKS = 1 << (32 - CHUNK_BITS);
+
+  static Flit * _chunks[MAX_CHUNKS];
+  static Handle _allocated;
+  static vector<Handle> _free;
+
+  static bool _thread_safe;
+  static mutex _lock;
 
 };
 
@@ -39,6 +39,7 @@
 
 #include "router.hpp"
 #include "globals.hpp"
+#include "profiler.hpp"
 
 // ----------------------------------------------------------------------
 //  $Author: jbalfour $
@@ -71,6 +72,7 @@ void FlitChannel::Send(Flit * f) {
 }
 
 void FlitChannel::ReadInputs() {
+  PROFILE_PHASE( CHANNEL );
   Flit const * const & f = _input;
   if(f && f->watch) {
     *gWatchOut << GetSimTime() << " | " << FullName() << " | "
@@ -82,6 +84,7 @@ void FlitChannel::ReadInputs() {
 }
 
 void FlitChannel::WriteOutputs() {
+  PROFILE_PHASE( CHANNEL );
   Channel<Flit>::WriteOutputs();
   if(_output && _output->watch) {
     *gWatchOut << GetSimTime() << " | " << FullName() << " | "
@@ -89,3 +92,9 @@ void FlitChannel::WriteOutputs() {
 	       << "." << endl;
   }
 }
+
+void FlitChannel::Checkpoint(CheckpointFile & cp) {
+  Channel<Flit>::Checkpoint(cp);
+  cp.Io(_active);
+  cp.Io(_idle);
+}
@@ -78,6 +78,8 @@ public:
   virtual void ReadInputs();
   virtual void WriteOutputs();
 
+  virtual void Checkpoint(CheckpointFile & cp);
+
 private:
 
   ////////////////////////////////////////
@@ -0,0 +1,105 @@
+/*hdr_histogram.cpp
+ *
+ *Log-linear histogram for latency quantiles
+ *
+ */
+
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+
+#include "booksim.hpp"
+#include "hdr_histogram.hpp"
+
+// values beyond this many units share the last octave
+static uint64_t const MAX_UNITS = (uint64_t)1 << 62;
+
+HdrHistogram::HdrHistogram( double resolution, int precision )
+  : _resolution( resolution ), _precision( precision ), _num_samples( 0 )
+{
+  assert( _resolution > 0.0 );
+  assert( ( _precision >= 0 ) && ( _precision < 30 ) );
+}
+
+void HdrHistogram::Clear( )
+{
+  fill( _counts.begin( ), _counts.end( ), 0 );
+  _num_samples = 0;
+}
+
+int HdrHistogram::_Bucket( uint64_t units ) const
+{
+  uint64_t const sub = (uint64_t)1 << _precision;
+  if ( units < 2 * sub ) {
+    return (int)units;
+  }
+  // units has its top bit at position precision + shift
+  int const shift = 63 - __builtin_clzll( units ) - _precision;
+  return (int)( shift * sub + ( units >> shift ) );
+}
+
+double HdrHistogram::_BucketValue( int bucket ) const
+{
+  int const sub = 1 << _precision;
+  if ( bucket < 2 * sub ) {
+    return bucket * _resolution;
+  }
+  int const shift = bucket / sub - 1;
+  double const low = ldexp( (double)( bucket - shift * sub ), shift );
+  double const width = ldexp( 1.0, shift );
+  return ( low + ( width - 1.0 ) / 2.0 ) * _resolution;
+}
+
+void HdrHistogram::AddSample( double val, int64_t count )
+{
+  double const scaled = floor( val / _resolution );
+  uint64_t units;
+  if ( !( scaled > 0.0 ) ) {
+    units = 0;
+  } else if ( scaled >= (double)MAX_UNITS ) {
+    units = MAX_UNITS;
+  } else {
+    units = (uint64_t)scaled;
+  }
+  size_t const b = _Bucket( units );
+  if ( b >= _counts.size( ) ) {
+    _counts.resize( b + 1, 0 );
+  }
+  _counts[b] += count;
+  _num_samples += count;
+}
+
+void HdrHistogram::Merge( HdrHistogram const & other )
+{
+  assert( ( _resolution == other._resolution ) && ( _precision == other._precision ) );
+  if ( other._counts.size( ) > _counts.size( ) ) {
+    _counts.resize( other._counts.size( ), 0 );
+  }
+  for ( size_t b = 0; b < other._counts.size( ); ++b ) {
+    _counts[b] += other._counts[b];
+  }
+  _num_samples += other._num_samples;
+}
+
+double HdrHistogram::Quantile( double q ) const
+{
+  if ( _num_samples == 0 ) {
+    return 0.0;
+  }
+  int64_t rank = (int64_t)ceil( q * (double)_num_samples );
+  rank = max( rank, (int64_t)1 );
+  int64_t seen = 0;
+  for ( size_t b = 0; b < _counts.size( ); ++b ) {
+    seen += _counts[b];
+    if ( seen >= rank ) {
+      return _BucketValue( b );
+    }
+  }
+  return _BucketValue( _counts.size( ) - 1 );
+}
+
+void HdrHistogram::Checkpoint( CheckpointFile & cp )
+{
+  cp.Io( _counts );
+  cp.Io( _num_samples );
+}
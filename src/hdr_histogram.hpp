@@ -0,0 +1,55 @@
+/*hdr_histogram.hpp
+ *
+ *Log-linear histogram for quantile estimates, after HdrHistogram. Values are
+ *counted in units of a fixed resolution; below 2^(precision+1) units every
+ *value has its own bucket, above that each power of two is split into
+ *2^precision buckets, so a reported quantile is within a relative error of
+ *2^-precision of a recorded value. Inserting is O(1), two histograms with
+ *the same resolution and precision can be merged by adding their counts,
+ *and clearing keeps the storage.
+ *
+ */
+
+#ifndef _HDR_HISTOGRAM_HPP_
+#define _HDR_HISTOGRAM_HPP_
+
+#include <vector>
+#include <stdint.h>
+
+#include "checkpoint.hpp"
+
+using namespace std;
+
+class HdrHistogram {
+
+public:
+  HdrHistogram( double resolution = 1.0, int precision = 7 );
+
+  void Clear( );
+
+  // Negative values are counted as zero.
+  void AddSample( double val, int64_t count = 1 );
+
+  void Merge( HdrHistogram const & other );
+
+  // Smallest recorded value (within the bucket precision) such that at
+  // least a fraction q of all samples are less than or equal to it.
+  double Quantile( double q ) const;
+
+  inline int64_t NumSamples( ) const { return _num_samples; }
+
+  void Checkpoint( CheckpointFile & cp );
+
+private:
+  int _Bucket( uint64_t units ) const;
+  double _BucketValue( int bucket ) const;
+
+  double _resolution;
+  int _precision;
+
+  // grown on demand up to the largest bucket seen so far
+  vector<int64_t> _counts;
+  int64_t _num_samples;
+};
+
+#endif
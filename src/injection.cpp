@@ -29,6 +29,7 @@
 #include <vector>
 #include <cassert>
 #include <limits>
+#include <cmath>
 #include "random_utils.hpp"
 #include "injection.hpp"
 
@@ -60,6 +61,11 @@ void InjectionProcess::reset()
 
 }
 
+void InjectionProcess::Checkpoint(CheckpointFile & cp)
+{
+  cp.Error("injection process does not support checkpoints");
+}
+
 InjectionProcess * InjectionProcess::New(string const & inject, int nodes,
 					 vector<double> load,
 					 Configuration const * const config)
@@ -80,9 +86,11 @@ InjectionProcess * InjectionProcess::New(string const & inject, int nodes,
   }
   vector<string> params = tokenize_str(param_str);
 
+  bool const skip_ahead = config && (config->GetInt("injection_skip_ahead") > 0);
+
   InjectionProcess * result = NULL;
   if(process_name == "bernoulli") {
-    result = new BernoulliInjectionProcess(nodes, load);
+    result = new BernoulliInjectionProcess(nodes, load, skip_ahead);
   } else if(process_name == "on_off") {
     bool missing_params = false;
     double alpha = numeric_limits<double>::quiet_NaN();
@@ -134,7 +142,8 @@ InjectionProcess * InjectionProcess::New(string const & inject, int nodes,
     vector<double> alpha_vec(nodes, alpha);
     vector<double> beta_vec(nodes, beta);
     vector<double> r1_vec(nodes, r1);
-    result = new OnOffInjectionProcess(nodes, load, alpha_vec, beta_vec, r1_vec, initial);
+    result = new OnOffInjectionProcess(nodes, load, alpha_vec, beta_vec, r1_vec, initial,
+				       skip_ahead);
   } else if(process_name == "debug") {
   } else if (process_name == "component") {
     result = new ComponentInjectionProcess(nodes, param_str, config);
@@ -147,25 +156,96 @@ InjectionProcess * InjectionProcess::New(string const & inject, int nodes,
 
 //=============================================================
 
-BernoulliInjectionProcess::BernoulliInjectionProcess(int nodes, vector<double> rate)
-  : InjectionProcess(nodes, rate)
+// gaps at least this long never end
+static int64_t const NEVER = numeric_limits<int64_t>::max() / 2;
+
+// Number of failed trials before the first success, each succeeding with
+// probability p.
+static int64_t GeometricGap(double p)
+{
+  if(p >= 1.0) {
+    return 0;
+  }
+  if(p <= 0.0) {
+    return NEVER;
+  }
+  double const gap = floor(log1p(-RandomFloat()) / log1p(-p));
+  return (gap < (double)NEVER) ? (int64_t)gap : NEVER;
+}
+
+static int64_t GapReadyTime(int64_t gap)
+{
+  if(gap < 0) {
+    return GetSimTime();
+  }
+  return (gap >= NEVER) ? numeric_limits<int64_t>::max() : GetSimTime() + gap;
+}
+
+//=============================================================
+
+BernoulliInjectionProcess::BernoulliInjectionProcess(int nodes, vector<double> rate,
+						     bool skip_ahead)
+  : InjectionProcess(nodes, rate), _skip_ahead(skip_ahead)
 {
+  reset();
+}
 
+void BernoulliInjectionProcess::reset()
+{
+  if(_skip_ahead) {
+    _gap.assign(_nodes, -1);
+  }
 }
 
 bool BernoulliInjectionProcess::test(int source)
 {
   assert((source >= 0) && (source < _nodes));
-  return (RandomFloat() < _rate[source]);
+  if(!_skip_ahead) {
+    return (RandomFloat() < _rate[source]);
+  }
+  // drawn lazily, so that the draws come from the calling endpoint
+  int64_t & gap = _gap[source];
+  if(gap < 0) {
+    gap = GeometricGap(_rate[source]);
+  }
+  if(gap > 0) {
+    --gap;
+    return false;
+  }
+  gap = GeometricGap(_rate[source]);
+  return true;
+}
+
+int64_t BernoulliInjectionProcess::ready_time(int source)
+{
+  return _skip_ahead ? GapReadyTime(_gap[source]) : GetSimTime();
+}
+
+void BernoulliInjectionProcess::skip(int source, int64_t trials)
+{
+  if(_skip_ahead && (_gap[source] >= 0)) {
+    assert(_gap[source] >= trials);
+    _gap[source] -= trials;
+  }
+}
+
+void BernoulliInjectionProcess::Checkpoint(CheckpointFile & cp)
+{
+  // the gaps are only saved when skipping ahead
+  cp.Check("injection_skip_ahead", _skip_ahead);
+  if(_skip_ahead) {
+    cp.Io(_gap);
+  }
 }
 
 //=============================================================
 
 OnOffInjectionProcess::OnOffInjectionProcess(int nodes, vector<double> rate, 
 					     vector<double> alpha, vector<double> beta, 
-					     vector<double> r1, vector<int> initial)
+					     vector<double> r1, vector<int> initial,
+					     bool skip_ahead)
   : InjectionProcess(nodes, rate), 
-    _alpha(alpha), _beta(beta), _r1(r1), _initial(initial)
+    _alpha(alpha), _beta(beta), _r1(r1), _initial(initial), _skip_ahead(skip_ahead)
 {
   for (int i = 0; i < nodes; ++i){
     assert(alpha[i] <= 1.0);
@@ -190,6 +270,19 @@ OnOffInjectionProcess::OnOffInjectionProcess(int nodes, vector<double> rate,
 void OnOffInjectionProcess::reset()
 {
   _state = _initial;
+  if(_skip_ahead) {
+    _gap.assign(_nodes, -1);
+  }
+}
+
+// Calls until the next one that turns the process off or injects (on), or
+// turns it on (off).
+int64_t OnOffInjectionProcess::_DrawGap(int source) const
+{
+  if(_state[source]) {
+    return GeometricGap(_beta[source] + (1.0 - _beta[source]) * _r1[source]);
+  }
+  return GeometricGap(_alpha[source]);
 }
 
 bool OnOffInjectionProcess::test(int source)
@@ -198,6 +291,36 @@ bool OnOffInjectionProcess::test(int source)
 
   bool old_state = _state[source];
 
+  if(_skip_ahead) {
+    int64_t & gap = _gap[source];
+    if(gap < 0) {
+      gap = _DrawGap(source);
+    }
+    if(gap > 0) {
+      --gap;
+      return false;
+    }
+    bool inject;
+    if(old_state) {
+      // either turn off or stay on and inject, in proportion to the
+      // per-call probabilities of the two
+      double const off = _beta[source];
+      double const on_inject = (1.0 - _beta[source]) * _r1[source];
+      _state[source] = (RandomFloat() * (off + on_inject) >= off);
+      inject = _state[source];
+    } else {
+      _state[source] = true;
+      inject = (RandomFloat() < _r1[source]);
+    }
+    if ((!old_state) && _state[source]) {
+cout << source << ": Injection Process transitioned from off to on" << endl;
+    } else if (old_state && (!_state[source])) {
+cout << source << ": Injection Process transitioned from on to off" << endl;
+    }
+    gap = _DrawGap(source);
+    return inject;
+  }
+
   // advance state
   _state[source] = 
     _state[source] ? (RandomFloat() >= _beta[source]) : (RandomFloat() < _alpha[source]);
@@ -211,3 +334,25 @@ cout << source << ": Injection Process transitioned from on to off" << endl;
   // generate packet
   return _state[source] && (RandomFloat() < _r1[source]);
 }
+
+int64_t OnOffInjectionProcess::ready_time(int source)
+{
+  return _skip_ahead ? GapReadyTime(_gap[source]) : GetSimTime();
+}
+
+void OnOffInjectionProcess::skip(int source, int64_t trials)
+{
+  if(_skip_ahead && (_gap[source] >= 0)) {
+    assert(_gap[source] >= trials);
+    _gap[source] -= trials;
+  }
+}
+
+void OnOffInjectionProcess::Checkpoint(CheckpointFile & cp)
+{
+  cp.Io(_state);
+  cp.Check("injection_skip_ahead", _skip_ahead);
+  if(_skip_ahead) {
+    cp.Io(_gap);
+  }
+}
@@ -30,6 +30,7 @@
 
 #include "config_utils.hpp"
 #include "wkld_comp.hpp"
+#include "checkpoint.hpp"
 
 using namespace std;
 
@@ -48,14 +49,34 @@ public:
   virtual void print_stats() {}
   virtual void set_state(int node, float val) {}
 
+  // the endpoint skipped this many cycles in which the process was asked and
+  // declined, see ready_time()
+  virtual void skip(int source, int64_t trials) {}
+
+  // saves or restores the per-node state; workload-driven processes cannot
+  // be checkpointed and report an error
+  virtual void Checkpoint(CheckpointFile & cp);
+
   static InjectionProcess * New(string const & inject, int nodes, vector<double> load,
 				Configuration const * const config = NULL);
 };
 
+// With skip-ahead, the processes below draw the number of calls to test()
+// until the next one that injects (or changes the on/off state) from a
+// geometric distribution, instead of a random number on every call. Between
+// those events, test() only counts down, and ready_time() can tell the
+// endpoint how long it may skip.
 class BernoulliInjectionProcess : public InjectionProcess {
+private:
+  bool _skip_ahead;
+  vector<int64_t> _gap; // calls left that decline, -1 = not drawn yet
 public:
-  BernoulliInjectionProcess(int nodes, vector<double> rate);
+  BernoulliInjectionProcess(int nodes, vector<double> rate, bool skip_ahead = false);
+  virtual void reset();
   virtual bool test(int source);
+  virtual int64_t ready_time(int source);
+  virtual void skip(int source, int64_t trials);
+  virtual void Checkpoint(CheckpointFile & cp);
 };
 
 class OnOffInjectionProcess : public InjectionProcess {
@@ -65,11 +86,17 @@ private:
   vector<double> _r1;
   vector<int> _initial;
   vector<int> _state;
+  bool _skip_ahead;
+  vector<int64_t> _gap;
+  int64_t _DrawGap(int source) const;
 public:
   OnOffInjectionProcess(int nodes, vector<double> rate, vector<double> alpha, vector<double> beta,
-			vector<double> r1, vector<int> initial);
+			vector<double> r1, vector<int> initial, bool skip_ahead = false);
   virtual void reset();
   virtual bool test(int source);
+  virtual int64_t ready_time(int source);
+  virtual void skip(int source, int64_t trials);
+  virtual void Checkpoint(CheckpointFile & cp);
 };
 
 #endif
@@ -35,9 +35,13 @@
  *
  */
 #include <sys/time.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <string>
 #include <cstdlib>
+#include <cstdio>
 #include <iostream>
 #include <fstream>
 #include <signal.h>
@@ -53,6 +57,7 @@
 #include "network.hpp"
 #include "injection.hpp"
 #include "power_module.hpp"
+#include "profiler.hpp"
 
 
 
@@ -104,7 +109,7 @@ ostream * gWatchOut;
 
 /////////////////////////////////////////////////////////////////////////////
 
-bool Simulate( BookSimConfig const & config )
+vector<Network *> BuildNetworks( BookSimConfig const & config )
 {
   vector<Network *> net;
 
@@ -118,6 +123,13 @@ bool Simulate( BookSimConfig const & config )
     name << "network_" << i;
     net[i] = Network::New( config, name.str() );
   }
+  return net;
+}
+
+bool Simulate( BookSimConfig const & config )
+{
+  vector<Network *> net = BuildNetworks( config );
+  int subnets = net.size();
 
   /*tcc and characterize are legacy
    *not sure how to use them
@@ -143,6 +155,10 @@ bool Simulate( BookSimConfig const & config )
 
   cout<<"Total run time = "<<total_time<<endl;
 
+  if ( Profiler::Enabled( ) ) {
+    Profiler::Report( cout, total_time );
+  }
+
   for (int i=0; i<subnets; ++i) {
 
     ///Power analysis
@@ -166,6 +182,250 @@ bool Simulate( BookSimConfig const & config )
   return result;
 }
 
+/*Runs one point of a sweep in a forked child: applies the swept value,
+ *attaches a new traffic manager to the inherited networks and resumes from
+ *the warm-up checkpoint, if there is one. Output goes to log, the CSV rows
+ *to results.
+ */
+void RunSweepPoint( BookSimConfig & config, vector<Network *> const & net,
+                    string const & param, string const & value,
+                    string const & checkpoint, FILE * log, FILE * results )
+{
+  fflush(stdout);
+  dup2(fileno(log), STDOUT_FILENO);
+
+  config.ParseString(param + " = " + value);
+  config.Assign("checkpoint_save", "");
+  config.Assign("checkpoint_exit", 0);
+  config.Assign("checkpoint_restore", checkpoint);
+  if ( config.GetStr("telemetry_file") != "" ) {
+    config.Assign("telemetry_file", config.GetStr("telemetry_file") + "." + value);
+  }
+
+  cout << "SWEEP: " << param << " = " << value << endl;
+
+  // report this point only, not the warm-up the parent already simulated
+  Profiler::Reset( );
+  struct timeval start_time, end_time;
+  gettimeofday(&start_time, NULL);
+
+  // the warm-up traffic manager still owns the parent's state; leave it be
+  trafficManager = TrafficManager::New( config, net );
+  bool result = trafficManager->Run();
+
+  gettimeofday(&end_time, NULL);
+  if ( Profiler::Enabled( ) ) {
+    double const total_time =
+      ((double)(end_time.tv_sec) + (double)(end_time.tv_usec)/1000000.0)
+      - ((double)(start_time.tv_sec) + (double)(start_time.tv_usec)/1000000.0);
+    Profiler::Report( cout, total_time );
+  }
+
+  ostringstream csv;
+  trafficManager->DisplayOverallStatsCSV(csv);
+  istringstream lines(csv.str());
+  string line;
+  while ( getline(lines, line) ) {
+    if ( line.compare(0, 8, "results:") == 0 ) {
+      line = line.substr(8);
+    }
+    fprintf(results, "%s,%s\n", value.c_str(), line.c_str());
+  }
+
+  if(config.GetInt("sim_power") > 0){
+    for (size_t i = 0; i < net.size(); ++i) {
+      Power_Module pnet(net[i], config);
+      pnet.run();
+    }
+  }
+
+  cout << "Simulation = " << (result ? "PASSED!" : "FAILED!") << endl << endl;
+  // flushes the telemetry file, which _exit() would skip
+  delete trafficManager;
+  cout.flush();
+  fflush(stdout);
+  fflush(results);
+  _exit(result ? 0 : 1);
+}
+
+/*Runs the simulation once for every value in sweep_values. The networks are
+ *built and, if their routers support checkpoints, warmed up
+ *(checkpoint_period sample periods) only once; the sweep points are then
+ *forked off the warmed-up process and run concurrently, sweep_jobs at a
+ *time. Their output is replayed in sweep order and the
+ *overall statistics of all points are collected into one CSV file.
+ */
+bool SimulateSweep( BookSimConfig & config )
+{
+  string const param = config.GetStr("sweep_param");
+  vector<string> const values = config.GetStrArray("sweep_values");
+  if ( values.empty() ) {
+    cout << "Error: sweep_param is set but sweep_values is empty." << endl;
+    exit(-1);
+  }
+
+  int jobs = config.GetInt("sweep_jobs");
+  if ( jobs <= 0 ) {
+    jobs = max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+  }
+
+  // Worker threads do not survive fork(); the sweep runs its points in
+  // parallel instead.
+  if ( config.GetInt("sim_threads") > 1 ) {
+    cout << "Note: sim_threads is ignored in sweep mode." << endl;
+    config.Assign("sim_threads", 1);
+  }
+
+  vector<Network *> net = BuildNetworks( config );
+
+  // Only networks whose routers can be checkpointed share the warm-up;
+  // otherwise every point starts from the freshly built networks.
+  bool shared_warmup = true;
+  for ( size_t i = 0; i < net.size(); ++i ) {
+    shared_warmup = shared_warmup && net[i]->CanCheckpoint();
+  }
+  char checkpoint[] = "/tmp/booksim_sweep_XXXXXX";
+  if ( shared_warmup ) {
+    if ( config.GetInt("checkpoint_period") > config.GetInt("max_samples") ) {
+      cout << "Error: checkpoint_period (" << config.GetInt("checkpoint_period")
+           << ") must not exceed max_samples (" << config.GetInt("max_samples")
+           << "), or the shared warm-up cannot save its checkpoint." << endl;
+      exit(-1);
+    }
+    int fd = mkstemp(checkpoint);
+    if ( fd < 0 ) {
+      cout << "Error: cannot create the sweep checkpoint file." << endl;
+      exit(-1);
+    }
+    close(fd);
+    config.Assign("checkpoint_save", string(checkpoint));
+    config.Assign("checkpoint_exit", 1);
+  } else {
+    cout << "Note: the routers do not support checkpoints; every sweep point"
+         << " runs its own warm-up." << endl;
+    checkpoint[0] = '\0';
+  }
+
+  struct timeval start_time, end_time;
+  gettimeofday(&start_time, NULL);
+
+  assert(trafficManager == NULL);
+  if ( shared_warmup ) {
+    trafficManager = TrafficManager::New( config, net ) ;
+    if ( !trafficManager->Run() ) {
+      cout << "Warm-up failed, sweep not started." << endl;
+      unlink(checkpoint);
+      return false;
+    }
+    // the simulation can also end (e.g. converge) before checkpoint_period
+    struct stat saved;
+    if ( ( stat(checkpoint, &saved) != 0 ) || ( saved.st_size == 0 ) ) {
+      cout << "Error: the warm-up ended before checkpoint_period sample periods,"
+           << " no checkpoint was saved; sweep not started." << endl;
+      unlink(checkpoint);
+      return false;
+    }
+  }
+
+  vector<FILE *> logs(values.size(), NULL);
+  vector<FILE *> results(values.size(), NULL);
+  vector<pid_t> pids(values.size(), -1);
+  vector<bool> passed(values.size(), false);
+
+  size_t next = 0;
+  int running = 0;
+  while ( ( next < values.size() ) || ( running > 0 ) ) {
+    if ( ( next < values.size() ) && ( running < jobs ) ) {
+      logs[next] = tmpfile();
+      results[next] = tmpfile();
+      if ( !logs[next] || !results[next] ) {
+        cout << "Error: cannot create temporary files for the sweep." << endl;
+        exit(-1);
+      }
+      cout.flush();
+      fflush(stdout);
+      pid_t pid = fork();
+      if ( pid == 0 ) {
+        RunSweepPoint(config, net, param, values[next], checkpoint,
+                      logs[next], results[next]);
+      }
+      if ( pid < 0 ) {
+        cout << "Error: fork failed for sweep point " << values[next] << endl;
+        exit(-1);
+      }
+      pids[next++] = pid;
+      ++running;
+      continue;
+    }
+    int status;
+    pid_t pid = wait(&status);
+    if ( pid < 0 ) {
+      break;
+    }
+    for ( size_t i = 0; i < pids.size(); ++i ) {
+      if ( pids[i] == pid ) {
+        passed[i] = WIFEXITED(status) && ( WEXITSTATUS(status) == 0 );
+        --running;
+      }
+    }
+  }
+  if ( shared_warmup ) {
+    unlink(checkpoint);
+  }
+
+  gettimeofday(&end_time, NULL);
+  double total_time = ((double)(end_time.tv_sec) + (double)(end_time.tv_usec)/1000000.0)
+            - ((double)(start_time.tv_sec) + (double)(start_time.tv_usec)/1000000.0);
+
+  string const csv_file = config.GetStr("sweep_csv");
+  ostream * csv = &cout;
+  if ( csv_file != "-" ) {
+    csv = new ofstream(csv_file.c_str());
+  }
+
+  bool result = true;
+  char buffer[4096];
+  for ( size_t i = 0; i < values.size(); ++i ) {
+    size_t bytes;
+    cout << endl;
+    rewind(logs[i]);
+    while ( ( bytes = fread(buffer, 1, sizeof(buffer), logs[i]) ) > 0 ) {
+      cout.write(buffer, bytes);
+    }
+    fclose(logs[i]);
+    if ( !passed[i] ) {
+      cout << "SWEEP: " << param << " = " << values[i] << " FAILED" << endl;
+      result = false;
+    }
+  }
+  cout << "Total sweep time = " << total_time << endl;
+  for ( size_t i = 0; i < values.size(); ++i ) {
+    size_t bytes;
+    rewind(results[i]);
+    while ( ( bytes = fread(buffer, 1, sizeof(buffer), results[i]) ) > 0 ) {
+      csv->write(buffer, bytes);
+    }
+    fclose(results[i]);
+  }
+  if ( csv != &cout ) {
+    delete csv;
+  }
+
+  delete trafficManager;
+  trafficManager = NULL;
+  for ( size_t i = 0; i < net.size(); ++i ) {
+    delete net[i];
+  }
+
+  if (result) {
+    cout << "Sweep = PASSED!" << endl << endl;
+  } else {
+    cout << "Sweep = FAILED!" << endl << endl;
+  }
+
+  return result;
+}
+
 void ctrlc_callback_handler(int signum) {
   cout << "Caught Ctrl-C.  Dumping stats." << endl;
   trafficManager->EndSimulation();
@@ -206,6 +466,9 @@ int main( int argc, char **argv )
 
   /*configure and run the simulator
    */
-  bool result = Simulate( config );
+  Profiler::Enable( config.GetInt("profile") );
+
+  bool result = ( config.GetStr("sweep_param") != "" ) ?
+    SimulateSweep( config ) : Simulate( config );
   return result ? -1 : 0;
 }
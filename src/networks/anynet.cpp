@@ -55,12 +55,34 @@
 #include <sstream>
 #include <limits>
 #include <algorithm>
+#include <queue>
+#include <functional>
+#include <thread>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "parallel_engine.hpp"
+#include "random_utils.hpp"
 //this is a hack, I can't easily get the routing talbe out of the network
-map<int, int>* global_routing_table;
+AnyNet const * global_anynet;
 
 AnyNet::AnyNet( const Configuration &config, const string & name )
   :  Network( config, name ){
 
+  //all shortest paths are only needed to choose between them
+  ecmp = (config.GetStr("routing_function") == "adaptive");
+  route_threads = config.GetInt("anynet_threads");
+  if(route_threads <= 0){
+    route_threads = max(1, (int)thread::hardware_concurrency());
+  }
+  cache_dir = config.GetStr("anynet_cache");
+  next_port_table = NULL;
+  ecmp_table = NULL;
+  cache_map = NULL;
+  cache_size = 0;
   router_list.resize(2);
   _ComputeSize( config );
   _Alloc( );
@@ -75,6 +97,9 @@ AnyNet::~AnyNet(){
       iter->second.clear();
     }
   }
+  if(cache_map){
+    munmap(cache_map, cache_size);
+  }
 }
 
 void AnyNet::_ComputeSize( const Configuration &config ){
@@ -83,69 +108,93 @@ void AnyNet::_ComputeSize( const Configuration &config ){
     cout<<"No network file name provided"<<endl;
     exit(-1);
   }
-  //parse the network description file
-  readFile();
+  //parse the network description file, unless it was cached
+  if(!loadCache()){
+    readFile();
+    flattenLists();
+  }
 
-  _channels =0;
   cout<<"========================Network File Parsed=================\n";
   cout<<"******************node listing**********************\n";
-  map<int,  int >::iterator iter;
-  for(iter = node_list.begin(); iter!=node_list.end(); iter++){
-    cout<<"Node "<<iter->first;
-    cout<<"\tRouter "<<iter->second<<endl;
+  for(int n = 0; n < _nodes; n++){
+    cout<<"Node "<<n;
+    cout<<"\tRouter "<<node_router[n]<<endl;
   }
 
-  map<int,   map<int, pair<int,int> > >::iterator iter3;
   cout<<"\n****************router to node listing*************\n";
-  for(iter3 = router_list[0].begin(); iter3!=router_list[0].end(); iter3++){
-    cout<<"Router "<<iter3->first<<endl;
-    map<int, pair<int,int> >::iterator iter2;
-    for(iter2 = iter3->second.begin();
-	iter2!=iter3->second.end();
-	iter2++){
-      cout<<"\t Node "<<iter2->first<<" lat "<<iter2->second.second<<endl;
+  for(int r = 0; r < _size; r++){
+    cout<<"Router "<<r<<endl;
+    for(int i = rnode_start[r]; i < rnode_start[r+1]; i++){
+      cout<<"\t Node "<<rnode[i]<<" lat "<<node_latency[rnode[i]]<<endl;
     }
   }
 
   cout<<"\n*****************router to router listing************\n";
-  for(iter3 = router_list[1].begin(); iter3!=router_list[1].end(); iter3++){
-    cout<<"Router "<<iter3->first<<endl;
-    map<int, pair<int,int> >::iterator iter2;
-    if(iter3->second.size() == 0){
-      cout<<"Caution Router "<<iter3->first
+  for(int r = 0; r < _size; r++){
+    cout<<"Router "<<r<<endl;
+    if(adj_start[r] == adj_start[r+1]){
+      cout<<"Caution Router "<<r
 	  <<" is not connected to any other Router\n"<<endl;
     }
-    for(iter2 = iter3->second.begin();
-	iter2!=iter3->second.end();
-	iter2++){
-      cout<<"\t Router "<<iter2->first<<" lat "<<iter2->second.second<<endl;
-      _channels++;
+    for(int i = adj_start[r]; i < adj_start[r+1]; i++){
+      cout<<"\t Router "<<adj_router[i]<<" lat "<<adj_latency[i]<<endl;
     }
   }
+}
 
+//turns the maps built by readFile into the compressed arrays and numbers
+//the ports of every router: its nodes first, then its router links
+void AnyNet::flattenLists(){
   _size = router_list[1].size();
   _nodes = node_list.size();
 
+  node_router.resize(_nodes);
+  node_port.resize(_nodes);
+  node_latency.resize(_nodes);
+  rnode_start.assign(_size+1, 0);
+  rnode.clear();
+  adj_start.assign(_size+1, 0);
+  adj_router.clear();
+  adj_latency.clear();
+  adj_port.clear();
+  for(int r = 0; r < _size; r++){
+    int port = 0;
+    map<int, pair<int,int> > const & nodes = router_list[0][r];
+    for(map<int, pair<int,int> >::const_iterator iter = nodes.begin();
+	iter!=nodes.end();
+	iter++){
+      node_router[iter->first] = r;
+      node_port[iter->first] = port++;
+      node_latency[iter->first] = iter->second.second;
+      rnode.push_back(iter->first);
+    }
+    rnode_start[r+1] = rnode.size();
+    map<int, pair<int,int> > const & links = router_list[1][r];
+    for(map<int, pair<int,int> >::const_iterator iter = links.begin();
+	iter!=links.end();
+	iter++){
+      adj_router.push_back(iter->first);
+      adj_latency.push_back(iter->second.second);
+      adj_port.push_back(port++);
+    }
+    adj_start[r+1] = adj_router.size();
+  }
+  _channels = adj_router.size();
+
+  node_list.clear();
+  router_list[0].clear();
+  router_list[1].clear();
 }
 
 
 
 void AnyNet::_BuildNet( const Configuration &config ){
 
-
-  //I need to keep track the output ports for each router during build
-  int * outport = (int*)malloc(sizeof(int)*_size);
-  for(int i = 0; i<_size; i++){outport[i] = 0;}
-
   cout<<"==========================Node to Router =====================\n";
   //adding the injection/ejection chanenls first
-  map<int,   map<int, pair<int,int> > >::iterator niter;
-  for(niter = router_list[0].begin(); niter!=router_list[0].end(); niter++){
-    map<int,   map<int, pair<int,int> > >::iterator riter = router_list[1].find(niter->first);
-    assert(riter != router_list[1].end());
+  for(int node = 0; node < _size; node++){
     //calculate radix
-    int radix = niter->second.size()+riter->second.size();
-    int node = niter->first;
+    int radix = (rnode_start[node+1] - rnode_start[node]) + (adj_start[node+1] - adj_start[node]);
     cout<<"router "<<node<<" radix "<<radix<<endl;
     //decalre the routers
     ostringstream router_name;
@@ -155,18 +204,15 @@ void AnyNet::_BuildNet( const Configuration &config ){
     					node, radix, radix );
     _timed_modules.push_back(_routers[node]);
     //add injeciton ejection channels
-    map<int, pair<int,int> >::iterator nniter;
-    for(nniter = niter->second.begin();nniter!=niter->second.end(); nniter++){
-      int link = nniter->first;
-      //add the outport port assined to the map
-      (niter->second)[link].first = outport[node];
-      outport[node]++;
-      cout<<"\t connected to node "<<link<<" at outport "<<nniter->second.first
-	  <<" lat "<<nniter->second.second<<endl;
-      _inject[link]->SetLatency(nniter->second.second);
-      _inject_cred[link]->SetLatency(nniter->second.second);
-      _eject[link]->SetLatency(nniter->second.second);
-      _eject_cred[link]->SetLatency(nniter->second.second);
+    for(int i = rnode_start[node]; i < rnode_start[node+1]; i++){
+      int link = rnode[i];
+      int lat = node_latency[link];
+      cout<<"\t connected to node "<<link<<" at outport "<<node_port[link]
+	  <<" lat "<<lat<<endl;
+      _inject[link]->SetLatency(lat);
+      _inject_cred[link]->SetLatency(lat);
+      _eject[link]->SetLatency(lat);
+      _eject_cred[link]->SetLatency(lat);
 
       _routers[node]->AddInputChannel( _inject[link], _inject_cred[link] );
       _routers[node]->AddOutputChannel( _eject[link], _eject_cred[link] );
@@ -177,53 +223,171 @@ void AnyNet::_BuildNet( const Configuration &config ){
   cout<<"==========================Router to Router =====================\n";
   //add inter router channels
   //since there is no way to systematically number the channels we just start from 0
-  //the map, is a mapping of output->input
-  int channel_count = 0;
-  for(niter = router_list[0].begin(); niter!=router_list[0].end(); niter++){
-    map<int,   map<int, pair<int,int> > >::iterator riter = router_list[1].find(niter->first);
-    assert(riter != router_list[1].end());
-    int node = niter->first;
-    map<int, pair<int,int> >::iterator rriter;
+  //so channel i is the i-th entry of the link arrays
+  for(int node = 0; node < _size; node++){
     cout<<"router "<<node<<endl;
-    for(rriter = riter->second.begin();rriter!=riter->second.end(); rriter++){
-      int other_node = rriter->first;
-      int link = channel_count;
-      //add the outport port assined to the map
-      (riter->second)[other_node].first = outport[node];
-      outport[node]++;
+    for(int link = adj_start[node]; link < adj_start[node+1]; link++){
+      int other_node = adj_router[link];
       cout<<"\t connected to router "<<other_node<<" using link "<<link
-	  <<" at outport "<<rriter->second.first
-	  <<" lat "<<rriter->second.second<<endl;
+	  <<" at outport "<<adj_port[link]
+	  <<" lat "<<adj_latency[link]<<endl;
 
-      _chan[link]->SetLatency(rriter->second.second);
-      _chan_cred[link]->SetLatency(rriter->second.second);
+      _chan[link]->SetLatency(adj_latency[link]);
+      _chan_cred[link]->SetLatency(adj_latency[link]);
 
       _routers[node]->AddOutputChannel( _chan[link], _chan_cred[link] );
       _routers[other_node]->AddInputChannel( _chan[link], _chan_cred[link]);
-      channel_count++;
     }
   }
 
-  free(outport);
   buildRoutingTable();
 
 }
 
 
-void AnyNet::RegisterRoutingFunctions() {
-  gRoutingFunctionMap["min_anynet"] = &min_anynet;
+//binary cache layout: header, the int arrays in the order listed in
+//loadCache(), then the routing tables, each aligned to 8 bytes
+namespace {
+
+char const ANYNET_CACHE_MAGIC[8] = { 'B', 'S', 'A', 'N', 'Y', 'N', 'T', '1' };
+
+struct AnyNetCacheHeader {
+  char magic[8];
+  uint64_t hash;
+  int64_t routers;
+  int64_t nodes;
+  int64_t channels;
+  int64_t ecmp;
+};
+
+size_t align8(size_t n){
+  return (n + 7) & ~size_t(7);
 }
 
-void min_anynet( const Router *r, const Flit *f, int in_channel,
-		 OutputSet *outputs, bool inject ){
-  int out_port=-1;
-  if(!inject){
-    assert(global_routing_table[r->GetID()].count(f->dest)!=0);
-    out_port=global_routing_table[r->GetID()][f->dest];
+}
+
+bool AnyNet::loadCache(){
+  if(cache_dir == ""){
+    return false;
+  }
+
+  //FNV-1a over the network file and the options that change the tables
+  ifstream in(file_name.c_str(), ios::binary);
+  if(!in.is_open()){
+    cout<<"Anynet:can't open network file "<<file_name<<endl;
+    exit(-1);
+  }
+  file_hash = 14695981039346656037ULL;
+  char buf[65536];
+  while(in.read(buf, sizeof(buf)) || in.gcount() > 0){
+    for(streamsize i = 0; i < in.gcount(); i++){
+      file_hash = (file_hash ^ (unsigned char)buf[i]) * 1099511628211ULL;
+    }
+  }
+  ostringstream name;
+  name<<cache_dir<<"/anynet-"<<hex<<file_hash<<(ecmp ? "-ecmp" : "")<<".bin";
+  cache_file = name.str();
+
+  int fd = open(cache_file.c_str(), O_RDONLY);
+  if(fd < 0){
+    return false;
+  }
+  struct stat st;
+  void * map = MAP_FAILED;
+  if(fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(AnyNetCacheHeader)){
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if(map == MAP_FAILED){
+    return false;
   }
 
+  char const * p = static_cast<char const *>(map);
+  AnyNetCacheHeader h;
+  memcpy(&h, p, sizeof(h));
+  size_t const pairs = (size_t)h.routers * h.routers;
+  size_t const ints = 3 * h.nodes + 2 * (h.routers + 1) + h.nodes + 3 * h.channels;
+  size_t const tables = align8(pairs * sizeof(unsigned short)) + (h.ecmp ? pairs * sizeof(uint64_t) : 0);
+  if(memcmp(h.magic, ANYNET_CACHE_MAGIC, sizeof(h.magic)) != 0 || h.hash != file_hash ||
+     h.ecmp != ecmp || (size_t)st.st_size != align8(sizeof(h) + ints * sizeof(int)) + tables){
+    cout<<"Anynet:ignoring stale cache file "<<cache_file<<endl;
+    munmap(map, st.st_size);
+    return false;
+  }
+  cache_map = map;
+  cache_size = st.st_size;
+
+  _size = h.routers;
+  _nodes = h.nodes;
+  _channels = h.channels;
+  p += sizeof(h);
+  vector<int> * const arrays[] = { &node_router, &node_port, &node_latency, &rnode_start, &rnode,
+				   &adj_start, &adj_router, &adj_latency, &adj_port };
+  size_t const lengths[] = { (size_t)_nodes, (size_t)_nodes, (size_t)_nodes, (size_t)_size+1, (size_t)_nodes,
+			     (size_t)_size+1, (size_t)_channels, (size_t)_channels, (size_t)_channels };
+  for(int i = 0; i < 9; i++){
+    arrays[i]->resize(lengths[i]);
+    memcpy(arrays[i]->data(), p, lengths[i] * sizeof(int));
+    p += lengths[i] * sizeof(int);
+  }
+  p = static_cast<char const *>(map) + align8(p - static_cast<char const *>(map));
+  next_port_table = reinterpret_cast<unsigned short const *>(p);
+  p += align8(pairs * sizeof(unsigned short));
+  ecmp_table = ecmp ? reinterpret_cast<uint64_t const *>(p) : NULL;
+  cout<<"Anynet:loaded network and routing tables from "<<cache_file<<endl;
+  return true;
+}
 
-  int vcBegin = 0, vcEnd = gNumVCs-1;
+void AnyNet::saveCache() const {
+  if(cache_dir == ""){
+    return;
+  }
+  //write to a private file and rename it, so that concurrent runs never
+  //see a partial cache
+  ostringstream tmp;
+  tmp<<cache_file<<".tmp"<<getpid();
+  FILE * f = fopen(tmp.str().c_str(), "wb");
+  if(!f){
+    cout<<"Anynet:can't create cache file "<<tmp.str()<<endl;
+    return;
+  }
+  AnyNetCacheHeader h;
+  memcpy(h.magic, ANYNET_CACHE_MAGIC, sizeof(h.magic));
+  h.hash = file_hash;
+  h.routers = _size;
+  h.nodes = _nodes;
+  h.channels = _channels;
+  h.ecmp = ecmp;
+  fwrite(&h, sizeof(h), 1, f);
+  vector<int> const * const arrays[] = { &node_router, &node_port, &node_latency, &rnode_start, &rnode,
+					 &adj_start, &adj_router, &adj_latency, &adj_port };
+  size_t written = sizeof(h);
+  for(int i = 0; i < 9; i++){
+    fwrite(arrays[i]->data(), sizeof(int), arrays[i]->size(), f);
+    written += arrays[i]->size() * sizeof(int);
+  }
+  char const zeros[8] = { 0 };
+  fwrite(zeros, 1, align8(written) - written, f);
+  fwrite(next_port.data(), sizeof(unsigned short), next_port.size(), f);
+  written = next_port.size() * sizeof(unsigned short);
+  fwrite(zeros, 1, align8(written) - written, f);
+  if(ecmp){
+    fwrite(ecmp_links.data(), sizeof(uint64_t), ecmp_links.size(), f);
+  }
+  if(fclose(f) != 0 || rename(tmp.str().c_str(), cache_file.c_str()) != 0){
+    cout<<"Anynet:writing cache file "<<cache_file<<" failed"<<endl;
+    remove(tmp.str().c_str());
+  }
+}
+
+void AnyNet::RegisterRoutingFunctions() {
+  gRoutingFunctionMap["min_anynet"] = &min_anynet;
+  gRoutingFunctionMap["adaptive_anynet"] = &adaptive_anynet;
+}
+
+static void anynet_vc_range( const Flit *f, int &vcBegin, int &vcEnd ){
+  vcBegin = 0;
+  vcEnd = gNumVCs-1;
   if ( f->type == Flit::READ_REQUEST ) {
     vcBegin = gReadReqBeginVC;
     vcEnd   = gReadReqEndVC;
@@ -237,88 +401,162 @@ void min_anynet( const Router *r, const Flit *f, int in_channel,
     vcBegin = gWriteReplyBeginVC;
     vcEnd   = gWriteReplyEndVC;
   }
+}
+
+void min_anynet( const Router *r, const Flit *f, int in_channel,
+		 OutputSet *outputs, bool inject ){
+  int out_port=-1;
+  if(!inject){
+    out_port=global_anynet->MinPort(r->GetID(), f->dest);
+  }
+
+  int vcBegin, vcEnd;
+  anynet_vc_range(f, vcBegin, vcEnd);
 
   outputs->Clear( );
 
   outputs->AddRange( out_port , vcBegin, vcEnd );
 }
 
+//picks the least loaded of the ports on shortest paths, ties at random
+void adaptive_anynet( const Router *r, const Flit *f, int in_channel,
+		      OutputSet *outputs, bool inject ){
+  int out_port=-1;
+  if(!inject){
+    vector<int> ports;
+    global_anynet->ShortestPorts(r->GetID(), f->dest, ports);
+    assert(!ports.empty());
+    out_port = ports[0];
+    if(ports.size() > 1){
+      int best = numeric_limits<int>::max();
+      int ties = 0;
+      for(size_t i = 0; i < ports.size(); i++){
+	int const used = r->GetUsedCredit(ports[i]);
+	if(used < best){
+	  best = used;
+	  out_port = ports[i];
+	  ties = 1;
+	} else if(used == best && RandomInt(ties++) == 0){
+	  out_port = ports[i];
+	}
+      }
+    }
+  }
+
+  int vcBegin, vcEnd;
+  anynet_vc_range(f, vcBegin, vcEnd);
+
+  outputs->Clear( );
+
+  outputs->AddRange( out_port , vcBegin, vcEnd );
+}
+
+void AnyNet::ShortestPorts(int router, int dest_node, vector<int> &ports) const {
+  int const dest_router = node_router[dest_node];
+  if(dest_router == router || !ecmp){
+    ports.push_back(MinPort(router, dest_node));
+    return;
+  }
+  uint64_t links = ecmp_table[(size_t)router * _size + dest_router];
+  for(int i = adj_start[router]; links; i++, links >>= 1){
+    if(links & 1){
+      ports.push_back(adj_port[i]);
+    }
+  }
+}
+
 void AnyNet::buildRoutingTable(){
   cout<<"========================== Routing table  =====================\n";
-  routing_table.resize(_size);
+  if(next_port_table){
+    //loaded from the cache
+    global_anynet = this;
+    return;
+  }
+  int max_degree = 0;
   for(int i = 0; i<_size; i++){
-    route(i);
+    max_degree = max(max_degree, adj_start[i+1] - adj_start[i]);
+  }
+  if(ecmp && max_degree > 64){
+    cout<<"Anynet:adaptive routing supports at most 64 router links per router\n";
+    exit(-1);
   }
-  global_routing_table = &routing_table[0];
-}
 
+  size_t const pairs = (size_t)_size * _size;
+  next_port.assign(pairs, numeric_limits<unsigned short>::max());
+  if(ecmp){
+    ecmp_links.assign(pairs, 0);
+  }
+
+  //sources are independent, each thread takes every route_threads-th one
+  int const threads = min(route_threads, _size);
+  ParallelEngine engine(threads);
+  engine.Run([this, threads](int p){
+      vector<int> dist, first_link, order;
+      for(int i = p; i<_size; i += threads){
+	route(i, dist, first_link, order);
+      }
+    });
 
-//11/7/2012
-//basically djistra's, tested on a large dragonfly anynet configuration
-void AnyNet::route(int r_start){
-  int dist[_size];
-  int prev[_size];
-  set<int> rlist;
   for(int i = 0; i<_size; i++){
-    dist[i] =  numeric_limits<int>::max();
-    prev[i] = -1;
-    rlist.insert(i);
-  }
-  dist[r_start] = 0;
-  while(!rlist.empty()){
-    //find min
-    int min_dist = numeric_limits<int>::max();
-    int min_cand = -1;
-    for(set<int>::iterator i = rlist.begin();
-	i!=rlist.end();
-	i++){
-      if(dist[*i]<min_dist){
-	min_dist = dist[*i];
-	min_cand = *i;
+    for(int j = 0; j<_size; j++){
+      if(i != j && next_port[(size_t)i * _size + j] == numeric_limits<unsigned short>::max()){
+	cout<<"Anynet:router "<<j<<" cannot be reached from router "<<i<<endl;
+	exit(-1);
       }
     }
-    rlist.erase(min_cand);
+  }
+  next_port_table = &next_port[0];
+  ecmp_table = ecmp ? &ecmp_links[0] : NULL;
+  global_anynet = this;
+  saveCache();
+}
+
 
-    assert(min_cand >= 0);
+//basically djistra's with a binary heap; routers at equal distance are
+//settled in increasing order, so paths match the original linear scan
+void AnyNet::route(int r_start, vector<int> &dist, vector<int> &first_link, vector<int> &order){
+  dist.assign(_size, numeric_limits<int>::max());
+  first_link.assign(_size, -1);
+  order.clear();
+  typedef pair<int, int> entry;
+  priority_queue<entry, vector<entry>, greater<entry> > heap;
+  dist[r_start] = 0;
+  heap.push(entry(0, r_start));
+  while(!heap.empty()){
+    entry const top = heap.top();
+    heap.pop();
+    int const cand = top.second;
+    if(top.first > dist[cand]){
+      continue; //stale
+    }
+    order.push_back(cand);
     //neighbor
-    for(map<int,pair<int,int> >::iterator i = router_list[1][min_cand].begin();
-	i!=router_list[1][min_cand].end();
-	i++){
-      int new_dist = dist[min_cand] + i->second.second;//distance is hops not cycles
-      if(new_dist < dist[i->first]){
-	dist[i->first] = new_dist;
-	prev[i->first] = min_cand;
+    for(int i = adj_start[cand]; i < adj_start[cand+1]; i++){
+      int const other = adj_router[i];
+      int new_dist = dist[cand] + adj_latency[i];
+      if(new_dist < dist[other]){
+	dist[other] = new_dist;
+	first_link[other] = (cand == r_start) ? i : first_link[cand];
+	heap.push(entry(new_dist, other));
       }
     }
   }
 
-  //post process from the prev list
-  for(int i = 0; i<_size; i++){
-    if(prev[i] ==-1){ //self
-      assert(i == r_start);
-      for(map<int, pair<int, int> >::iterator iter = router_list[0][i].begin();
-	  iter!=router_list[0][i].end();
-	  iter++){
-	routing_table[r_start][iter->first]=iter->second.first;
-	//cout<<"node "<<iter->first<<" port "<< iter->second.first<<endl;
-      }
-    } else {
-      int __attribute__((unused)) distance=0;
-      int neighbor=i;
-      while(prev[neighbor]!=r_start){
-	assert(router_list[1][neighbor].count(prev[neighbor])>0);
-	distance+=router_list[1][prev[neighbor]][neighbor].second;//REVERSE lat
-	neighbor= prev[neighbor];
-      }
-      distance+=router_list[1][prev[neighbor]][neighbor].second;//lat
-
-      assert( router_list[1][r_start].count(neighbor)!=0);
-      int port = router_list[1][r_start][neighbor].first;
-      for(map<int, pair<int,int> >::iterator iter = router_list[0][i].begin();
-	  iter!=router_list[0][i].end();
-	  iter++){
-	routing_table[r_start][iter->first]=port;
-	//cout<<"node "<<iter->first<<" port "<< port<<" dist "<<distance<<endl;
+  unsigned short * const row = &next_port[(size_t)r_start * _size];
+  for(size_t k = 1; k < order.size(); k++){
+    row[order[k]] = adj_port[first_link[order[k]]];
+  }
+
+  if(ecmp){
+    //first links of all shortest paths, pushed forward in settling order
+    uint64_t * const links = &ecmp_links[(size_t)r_start * _size];
+    for(size_t k = 0; k < order.size(); k++){
+      int const cand = order[k];
+      for(int i = adj_start[cand]; i < adj_start[cand+1]; i++){
+	int const other = adj_router[i];
+	if(other != r_start && dist[cand] + adj_latency[i] == dist[other]){
+	  links[other] |= (cand == r_start) ? (uint64_t(1) << (i - adj_start[cand])) : links[cand];
+	}
       }
     }
   }
@@ -34,6 +34,8 @@
 #include <string>
 #include <map>
 #include <list>
+#include <vector>
+#include <stdint.h>
 
 class AnyNet : public Network {
 
@@ -42,15 +44,47 @@ class AnyNet : public Network {
   map<int, int > node_list;
   //[link type][src router][dest router]=(port, latency)
   vector<map<int,  map<int, pair<int,int> > > > router_list;
-  //stores minimal routing information from every router to every node
-  //[router][dest_node]=port
-  vector<map<int, int> > routing_table;
+
+  //the parsed network in compressed form, see flattenLists(). Each
+  //router's nodes and links are sorted by ID; [rnode_start[r],
+  //rnode_start[r+1]) and [adj_start[r], adj_start[r+1]) index the arrays
+  vector<int> node_router;    //[node]=router it is attached to
+  vector<int> node_port;      //[node]=port of that router
+  vector<int> node_latency;   //[node]=injection and ejection channel latency
+  vector<int> rnode_start;
+  vector<int> rnode;
+  vector<int> adj_start;
+  vector<int> adj_router;
+  vector<int> adj_latency;
+  vector<int> adj_port;
+
+  //minimal routing information, as dense [router * _size + dest_router]
+  //arrays, either in the vectors or in the mapped cache file
+  //port of the first hop on a shortest path
+  vector<unsigned short> next_port;
+  unsigned short const * next_port_table;
+  //first hops of all shortest paths, as a mask over the router's links
+  //(bit i is adj_port[adj_start[router] + i]); only for adaptive routing
+  vector<uint64_t> ecmp_links;
+  uint64_t const * ecmp_table;
+  bool ecmp;
+  int route_threads;
+
+  //binary cache of the above, keyed by a hash of the network file
+  string cache_dir;
+  string cache_file;
+  uint64_t file_hash;
+  void * cache_map;
+  size_t cache_size;
 
   void _ComputeSize( const Configuration &config );
   void _BuildNet( const Configuration &config );
   void readFile();
+  void flattenLists();
+  bool loadCache();
+  void saveCache() const;
   void buildRoutingTable();
-  void route(int r_start);
+  void route(int r_start, vector<int> &dist, vector<int> &first_link, vector<int> &order);
 
 public:
   AnyNet( const Configuration &config, const string & name );
@@ -62,8 +96,21 @@ public:
   static void RegisterRoutingFunctions();
   double Capacity( ) const {return -1;}
   void InsertRandomFaults( const Configuration &config ){}
+
+  //output port towards dest_node on a shortest path
+  inline int MinPort(int router, int dest_node) const {
+    int const dest_router = node_router[dest_node];
+    if(dest_router == router){
+      return node_port[dest_node];
+    }
+    return next_port_table[(size_t)router * _size + dest_router];
+  }
+  //appends the output ports of all shortest paths towards dest_node
+  void ShortestPorts(int router, int dest_node, vector<int> &ports) const;
 };
 
 void min_anynet( const Router *r, const Flit *f, int in_channel, 
 		      OutputSet *outputs, bool inject );
+void adaptive_anynet( const Router *r, const Flit *f, int in_channel,
+		      OutputSet *outputs, bool inject );
 #endif
@@ -101,8 +101,18 @@ int dragonflynew_hopcnt(int src, int dest)
 }
 
 
-//packet output port based on the source, destination and current location
-int dragonfly_port(int rID, int source, int dest){
+// Routing tables, filled in by DragonFlyNew::_BuildRoutingTables. Routing
+// runs for every head flit at every hop, so the group and router
+// arithmetic is done once per network rather than once per route.
+static vector<int> gNodeRouter;   // router a node is attached to
+static vector<int> gRouterGroup;  // group of a router
+static vector<int> gRouterLocal;  // index of a router within its group
+static vector<int> gGroupPort;    // [rID * gG + group] port towards another group
+static vector<int> gLocalPort;    // [rID * gA + local] port to a router of the same group
+
+//packet output port based on the source, destination and current location,
+//computed from scratch; only used to fill the routing tables
+static int dragonfly_port_compute(int rID, int dest){
   int _grp_num_routers= gA;
   int _grp_num_nodes =_grp_num_routers*gP;
 
@@ -145,6 +155,20 @@ int dragonfly_port(int rID, int source, int dest){
   return out_port;
 }
 
+//packet output port based on the source, destination and current location
+int dragonfly_port(int rID, int source, int dest){
+  int const dest_rID = gNodeRouter[dest];
+  if (dest_rID == rID) {
+    //At the last hop
+    return dest - rID*gP;
+  }
+  int const dest_grp_ID = gRouterGroup[dest_rID];
+  if (dest_grp_ID == gRouterGroup[rID]) {
+    return gLocalPort[rID*gA + gRouterLocal[dest_rID]];
+  }
+  return gGroupPort[rID*gG + dest_grp_ID];
+}
+
 
 DragonFlyNew::DragonFlyNew( const Configuration &config, const string & name ) :
   Network( config, name )
@@ -377,6 +401,37 @@ void DragonFlyNew::_BuildNet( const Configuration &config )
   }
 
   cout<<"Done links"<<endl;
+
+  _BuildRoutingTables( );
+}
+
+void DragonFlyNew::_BuildRoutingTables( )
+{
+  gNodeRouter.resize(_nodes);
+  for ( int node = 0; node < _nodes; ++node ) {
+    gNodeRouter[node] = node / _p;
+  }
+  gRouterGroup.resize(_num_of_switch);
+  gRouterLocal.resize(_num_of_switch);
+  gGroupPort.assign(_num_of_switch * _g, -1);
+  gLocalPort.assign(_num_of_switch * _a, -1);
+  for ( int rID = 0; rID < _num_of_switch; ++rID ) {
+    int const grp_ID = rID / _a;
+    gRouterGroup[rID] = grp_ID;
+    gRouterLocal[rID] = rID % _a;
+    // any node of the destination group or router gives the same port
+    for ( int grp = 0; grp < _g; ++grp ) {
+      if ( grp != grp_ID ) {
+        gGroupPort[rID * _g + grp] = dragonfly_port_compute(rID, grp * _grp_num_nodes);
+      }
+    }
+    for ( int local = 0; local < _a; ++local ) {
+      int const dest_rID = grp_ID * _a + local;
+      if ( dest_rID != rID ) {
+        gLocalPort[rID * _a + local] = dragonfly_port_compute(rID, dest_rID * _p);
+      }
+    }
+  }
 }
 
 
@@ -418,12 +473,10 @@ void min_dragonflynew( const Router *r, const Flit *f, int in_channel,
     return;
   }
 
-  int _grp_num_routers= gA;
-
   int dest  = f->dest;
   int rID =  r->GetID();
 
-  int grp_ID = int(rID / _grp_num_routers);
+  int grp_ID = gRouterGroup[rID];
   int debug = f->watch;
   int out_port = -1;
   int out_vc = 0;
@@ -471,15 +524,13 @@ void ugal_dragonflynew( const Router *r, const Flit *f, int in_channel,
   //negative value woudl biases it towards nonminimum routing
   int adaptive_threshold = 30;
 
-  int _grp_num_routers= gA;
-  int _grp_num_nodes =_grp_num_routers*gP;
   int _network_size =  gA * gP * gG;
 
 
   int dest  = f->dest;
   int rID =  r->GetID();
-  int grp_ID = (int) (rID / _grp_num_routers);
-  int dest_grp_ID = int(dest/_grp_num_nodes);
+  int grp_ID = gRouterGroup[rID];
+  int dest_grp_ID = gRouterGroup[gNodeRouter[dest]];
 
   int debug = f->watch;
   int out_port = -1;
@@ -502,7 +553,7 @@ void ugal_dragonflynew( const Router *r, const Flit *f, int in_channel,
     } else {
       //select a random node
       f->intm =RandomInt(_network_size - 1);
-      intm_grp_ID = (int)(f->intm/_grp_num_nodes);
+      intm_grp_ID = gRouterGroup[gNodeRouter[f->intm]];
       if (debug){
 	cout<<"Intermediate node "<<f->intm<<" grp id "<<intm_grp_ID<<endl;
       }
@@ -532,7 +583,7 @@ void ugal_dragonflynew( const Router *r, const Flit *f, int in_channel,
 
   //transition from nonminimal phase to minimal
   if(f->ph==0){
-    intm_rID= (int)(f->intm/gP);
+    intm_rID= gNodeRouter[f->intm];
     if( rID == intm_rID){
       f->ph = 1;
     }
@@ -50,6 +50,7 @@ class DragonFlyNew : public Network {
 
   void _ComputeSize( const Configuration &config );
   void _BuildNet( const Configuration &config );
+  void _BuildRoutingTables( );
 
 
 
@@ -65,6 +65,22 @@ static int _ycount;
 static int _xrouter;
 static int _yrouter;
 
+// Routing tables, filled in by FlatFlyOnChip::_BuildRoutingTables. Routing
+// runs for every head flit at every hop, so the coordinate arithmetic is
+// done once per network rather than once per route.
+static int _num_routers;
+static vector<int> _transformed;   // flatfly_transformation() of each node
+static vector<int> _node_router;   // router of each (transformed) node
+static vector<int> _outport_xy;    // [rID * _num_routers + dest rID] minimal port, x first
+static vector<int> _outport_yx;    // [rID * _num_routers + dest rID] minimal port, y first
+static vector<int> _distance;      // [rID * _num_routers + dest rID] minimal hop count
+static vector<int> _dim_span;      // nodes spanned by one step in each dimension
+
+static int flatfly_outport_compute(int dest, int rID);
+static int flatfly_outport_yx_compute(int dest, int rID);
+static int find_distance_compute(int src, int dest);
+static int flatfly_transformation_compute(int dest);
+
 FlatFlyOnChip::FlatFlyOnChip( const Configuration &config, const string & name ) :
   Network( config, name )
 {
@@ -291,6 +307,36 @@ void FlatFlyOnChip::_BuildNet( const Configuration &config )
   if(gTrace){
     cout<<"Setup Finished Link"<<endl;
   }
+
+  _BuildRoutingTables( );
+}
+
+void FlatFlyOnChip::_BuildRoutingTables( )
+{
+  _num_routers = _num_of_switch;
+  _transformed.resize(_nodes);
+  _node_router.resize(_nodes);
+  for ( int node = 0; node < _nodes; ++node ) {
+    _transformed[node] = flatfly_transformation_compute(node);
+    _node_router[node] = node / _c;
+  }
+  _outport_xy.resize(_num_routers * _num_routers);
+  _outport_yx.resize(_num_routers * _num_routers);
+  _distance.resize(_num_routers * _num_routers);
+  for ( int rID = 0; rID < _num_routers; ++rID ) {
+    for ( int dest_rID = 0; dest_rID < _num_routers; ++dest_rID ) {
+      int const i = rID * _num_routers + dest_rID;
+      // only reached for routers other than the destination's, so any node
+      // of the destination router gives the same port
+      _outport_xy[i] = ( dest_rID == rID ) ? -1 : flatfly_outport_compute(dest_rID * _c, rID);
+      _outport_yx[i] = ( dest_rID == rID ) ? -1 : flatfly_outport_yx_compute(dest_rID * _c, rID);
+      _distance[i] = find_distance_compute(rID * _c, dest_rID * _c);
+    }
+  }
+  _dim_span.resize(_n);
+  for ( int d = 0; d < _n; ++d ) {
+    _dim_span[d] = powi(_k, d) * _c;
+  }
 }
 
 
@@ -467,7 +513,7 @@ void xyyx_flatfly( const Router *r, const Flit *f, int in_channel,
   outputs->AddRange( out_port , vcBegin, vcEnd );
 }
 
-int flatfly_outport_yx(int dest, int rID) {
+static int flatfly_outport_yx_compute(int dest, int rID) {
   int dest_rID = (int) (dest / gC);
   int _dim   = gN;
   int output = -1, dID, sID;
@@ -1201,7 +1247,7 @@ void ugal_pni_flatfly_onchip( const Router *r, const Flit *f, int in_channel,
 //=============================================================^M
 // UGAL : calculate distance (hop cnt)  between src and destination
 //=============================================================^M
-int find_distance (int src, int dest) {
+static int find_distance_compute (int src, int dest) {
   int dist = 0;
   int _dim   = gN;
 
@@ -1245,7 +1291,7 @@ int find_ran_intm (int src, int dest) {
   //if (debug) cout << " ............ _ran_dest : " << _ran_dest << endl;
   for (int d=0;d < _dim; d++) {
 
-    _dim_size = powi(gK, d)*gC;
+    _dim_size = _dim_span[d];
     if ((src % gK) ==  (dest % gK)) {
       _ran_dest += (src % gK) * _dim_size;
       //if (debug)
@@ -1272,7 +1318,7 @@ int find_ran_intm (int src, int dest) {
 // given the dimension and destination
 //=============================================================
 // starting from DIM 0 (x first)
-int flatfly_outport(int dest, int rID) {
+static int flatfly_outport_compute(int dest, int rID) {
   int dest_rID = (int) (dest / gC);
   int _dim   = gN;
   int output = -1, dID, sID;
@@ -1306,7 +1352,7 @@ int flatfly_outport(int dest, int rID) {
   return -1;
 }
 
-int flatfly_transformation(int dest){
+static int flatfly_transformation_compute(int dest){
   //the magic of destination transformation
 
   //destination transformation, translate how the nodes are actually arranged
@@ -1327,3 +1373,30 @@ int flatfly_transformation(int dest){
   //cout<<"Transformed destination "<<dest<<endl<<endl;
   return dest;
 }
+
+//=============================================================
+// table lookups used by the routing functions
+//=============================================================
+int find_distance (int src, int dest) {
+  return _distance[_node_router[src] * _num_routers + _node_router[dest]];
+}
+
+int flatfly_outport(int dest, int rID) {
+  int const dest_rID = _node_router[dest];
+  if(dest_rID==rID){
+    return dest - dest_rID * gC;
+  }
+  return _outport_xy[rID * _num_routers + dest_rID];
+}
+
+int flatfly_outport_yx(int dest, int rID) {
+  int const dest_rID = _node_router[dest];
+  if(dest_rID==rID){
+    return dest - dest_rID * gC;
+  }
+  return _outport_yx[rID * _num_routers + dest_rID];
+}
+
+int flatfly_transformation(int dest){
+  return _transformed[dest];
+}
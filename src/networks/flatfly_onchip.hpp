@@ -50,6 +50,7 @@ class FlatFlyOnChip : public Network {
 
   void _ComputeSize( const Configuration &config );
   void _BuildNet( const Configuration &config );
+  void _BuildRoutingTables( );
 
   int _OutChannel( int stage, int addr, int port, int outputs ) const;
   int _InChannel( int stage, int addr, int port ) const;
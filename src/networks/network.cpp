@@ -34,9 +34,13 @@
 
 #include <cassert>
 #include <sstream>
+#include <map>
+#include <new>
+#include <algorithm>
 
 #include "booksim.hpp"
 #include "network.hpp"
+#include "random_utils.hpp"
 
 #include "kncube.hpp"
 #include "fly.hpp"
@@ -50,7 +54,8 @@
 
 
 Network::Network( const Configuration &config, const string & name ) :
-  TimedModule( 0, name )
+  TimedModule( 0, name ), _flit_channel_block( NULL ),
+  _credit_channel_block( NULL ), _engine( NULL ), _active_set( false )
 {
   _size     = -1; 
   _nodes    = -1; 
@@ -64,17 +69,20 @@ Network::~Network( )
     if ( _routers[r] ) delete _routers[r];
   }
   for ( int s = 0; s < _nodes; ++s ) {
-    if ( _inject[s] ) delete _inject[s];
-    if ( _inject_cred[s] ) delete _inject_cred[s];
+    if ( _inject[s] ) _inject[s]->~FlitChannel( );
+    if ( _inject_cred[s] ) _inject_cred[s]->~CreditChannel( );
   }
   for ( int d = 0; d < _nodes; ++d ) {
-    if ( _eject[d] ) delete _eject[d];
-    if ( _eject_cred[d] ) delete _eject_cred[d];
+    if ( _eject[d] ) _eject[d]->~FlitChannel( );
+    if ( _eject_cred[d] ) _eject_cred[d]->~CreditChannel( );
   }
   for ( int c = 0; c < _channels; ++c ) {
-    if ( _chan[c] ) delete _chan[c];
-    if ( _chan_cred[c] ) delete _chan_cred[c];
+    if ( _chan[c] ) _chan[c]->~FlitChannel( );
+    if ( _chan_cred[c] ) _chan_cred[c]->~CreditChannel( );
   }
+  ::operator delete( _flit_channel_block );
+  ::operator delete( _credit_channel_block );
+  if ( _engine ) delete _engine;
 }
 
 Network * Network::New(const Configuration & config, const string & name)
@@ -121,6 +129,12 @@ Network * Network::New(const Configuration & config, const string & name)
   if ( n && ( config.GetInt( "link_failures" ) > 0 ) ) {
     n->InsertRandomFaults( config );
   }
+  if ( n && ( config.GetInt( "sim_threads" ) > 1 ) ) {
+    n->_Partition( config.GetInt( "sim_threads" ) );
+  }
+  if ( n && !n->_engine && ( config.GetInt( "active_set" ) > 0 ) ) {
+    n->_InitActiveSet( );
+  }
   return n;
 }
 
@@ -139,17 +153,25 @@ void Network::_Alloc( )
    *shifts by one
    *credit channels are the necessary counter part
    */
+  int const channel_objects = 2 * _nodes + _channels;
+  _flit_channel_block = static_cast<FlitChannel *>
+    ( ::operator new( channel_objects * sizeof( FlitChannel ) ) );
+  _credit_channel_block = static_cast<CreditChannel *>
+    ( ::operator new( channel_objects * sizeof( CreditChannel ) ) );
+  FlitChannel * next_flit_channel = _flit_channel_block;
+  CreditChannel * next_credit_channel = _credit_channel_block;
+
   _inject.resize(_nodes);
   _inject_cred.resize(_nodes);
   for ( int s = 0; s < _nodes; ++s ) {
     ostringstream name;
     name << Name() << "_fchan_ingress" << s;
-    _inject[s] = new FlitChannel(this, name.str(), _classes);
+    _inject[s] = new (next_flit_channel++) FlitChannel(this, name.str(), _classes);
     _inject[s]->SetSource(NULL, s);
     _timed_modules.push_back(_inject[s]);
     name.str("");
     name << Name() << "_cchan_ingress" << s;
-    _inject_cred[s] = new CreditChannel(this, name.str());
+    _inject_cred[s] = new (next_credit_channel++) CreditChannel(this, name.str());
     _timed_modules.push_back(_inject_cred[s]);
   }
   _eject.resize(_nodes);
@@ -157,12 +179,12 @@ void Network::_Alloc( )
   for ( int d = 0; d < _nodes; ++d ) {
     ostringstream name;
     name << Name() << "_fchan_egress" << d;
-    _eject[d] = new FlitChannel(this, name.str(), _classes);
+    _eject[d] = new (next_flit_channel++) FlitChannel(this, name.str(), _classes);
     _eject[d]->SetSink(NULL, d);
     _timed_modules.push_back(_eject[d]);
     name.str("");
     name << Name() << "_cchan_egress" << d;
-    _eject_cred[d] = new CreditChannel(this, name.str());
+    _eject_cred[d] = new (next_credit_channel++) CreditChannel(this, name.str());
     _timed_modules.push_back(_eject_cred[d]);
   }
   _chan.resize(_channels);
@@ -170,17 +192,173 @@ void Network::_Alloc( )
   for ( int c = 0; c < _channels; ++c ) {
     ostringstream name;
     name << Name() << "_fchan_" << c;
-    _chan[c] = new FlitChannel(this, name.str(), _classes);
+    _chan[c] = new (next_flit_channel++) FlitChannel(this, name.str(), _classes);
     _timed_modules.push_back(_chan[c]);
     name.str("");
     name << Name() << "_cchan_" << c;
-    _chan_cred[c] = new CreditChannel(this, name.str());
+    _chan_cred[c] = new (next_credit_channel++) CreditChannel(this, name.str());
     _timed_modules.push_back(_chan_cred[c]);
   }
 }
 
+/* Split the routers and channels into contiguous, equally sized slices so
+ * neighbouring routers (which share channels) tend to land on the same thread.
+ * Within a phase no two modules touch the same state: channels only consume
+ * their input in ReadInputs and only produce their output in WriteOutputs,
+ * while routers do the opposite. Phases therefore give the same result as the
+ * serial loop regardless of how the partitions are scheduled.
+ */
+void Network::_Partition( int threads )
+{
+  assert( threads > 1 );
+
+  vector<TimedModule *> routers;
+  vector<TimedModule *> others;
+  for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
+      iter != _timed_modules.end();
+      ++iter) {
+    if ( dynamic_cast<Router *>( *iter ) ) {
+      routers.push_back( *iter );
+    } else {
+      others.push_back( *iter );
+    }
+  }
+
+  threads = min( threads, (int)max( routers.size( ), (size_t)1 ) );
+
+  _partitions.assign( threads, vector<TimedModule *>( ) );
+  for ( size_t i = 0; i < routers.size( ); ++i ) {
+    _partitions[ i * threads / routers.size( ) ].push_back( routers[i] );
+  }
+  for ( size_t i = 0; i < others.size( ); ++i ) {
+    _partitions[ i * threads / others.size( ) ].push_back( others[i] );
+  }
+
+  if ( threads > 1 ) {
+    Flit::SetThreadSafe( true );
+    Credit::SetThreadSafe( true );
+    RandomSetThreadSafe( true );
+    _engine = new ParallelEngine( threads );
+  }
+}
+
+void Network::_InitActiveSet( )
+{
+  map<Router const *, int> router_index;
+  for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
+      iter != _timed_modules.end();
+      ++iter) {
+    if ( Router * r = dynamic_cast<Router *>( *iter ) ) {
+      router_index[r] = _sched_routers.size( );
+      _sched_routers.push_back( r );
+    } else if ( FlitChannel * fc = dynamic_cast<FlitChannel *>( *iter ) ) {
+      _flit_channels.push_back( fc );
+    } else if ( CreditChannel * cc = dynamic_cast<CreditChannel *>( *iter ) ) {
+      _credit_channels.push_back( cc );
+    } else {
+      _other_modules.push_back( *iter );
+    }
+  }
+
+  map<TimedModule const *, int> sink;
+  for ( size_t r = 0; r < _sched_routers.size( ); ++r ) {
+    vector<FlitChannel *> const & in = _sched_routers[r]->GetInputChannels( );
+    for ( size_t i = 0; i < in.size( ); ++i ) {
+      sink[in[i]] = r;
+    }
+    vector<CreditChannel *> const & cred = _sched_routers[r]->GetOutputCredits( );
+    for ( size_t i = 0; i < cred.size( ); ++i ) {
+      sink[cred[i]] = r;
+    }
+  }
+  _flit_channel_sink.assign( _flit_channels.size( ), -1 );
+  for ( size_t c = 0; c < _flit_channels.size( ); ++c ) {
+    map<TimedModule const *, int>::const_iterator iter = sink.find( _flit_channels[c] );
+    if ( iter != sink.end( ) ) {
+      _flit_channel_sink[c] = iter->second;
+    }
+  }
+  _credit_channel_sink.assign( _credit_channels.size( ), -1 );
+  for ( size_t c = 0; c < _credit_channels.size( ); ++c ) {
+    map<TimedModule const *, int>::const_iterator iter = sink.find( _credit_channels[c] );
+    if ( iter != sink.end( ) ) {
+      _credit_channel_sink[c] = iter->second;
+    }
+  }
+
+  for ( size_t c = 0; c < _flit_channels.size( ); ++c ) {
+    _flit_channels[c]->SetWorklist( &_active_flit_channels, c );
+  }
+  for ( size_t c = 0; c < _credit_channels.size( ); ++c ) {
+    _credit_channels[c]->SetWorklist( &_active_credit_channels, c );
+  }
+
+  // Everything starts out awake and drops out after its first cycle.
+  _WakeAll( 0 );
+  _active_set = true;
+}
+
+void Network::_WakeAll( int64_t now )
+{
+  _active_routers.resize( _sched_routers.size( ) );
+  for ( size_t r = 0; r < _sched_routers.size( ); ++r ) {
+    _active_routers[r] = r;
+  }
+  _router_awake.assign( _sched_routers.size( ), true );
+  _router_idle_since.assign( _sched_routers.size( ), now );
+  _active_flit_channels.resize( _flit_channels.size( ) );
+  for ( size_t c = 0; c < _flit_channels.size( ); ++c ) {
+    _active_flit_channels[c] = c;
+    _flit_channels[c]->SetListed( true );
+  }
+  _active_credit_channels.resize( _credit_channels.size( ) );
+  for ( size_t c = 0; c < _credit_channels.size( ); ++c ) {
+    _active_credit_channels[c] = c;
+    _credit_channels[c]->SetListed( true );
+  }
+}
+
+void Network::_WakeRouter( int r )
+{
+  if ( _router_awake[r] ) {
+    return;
+  }
+  // The router is evaluated again from the next cycle on; catch up on the
+  // cycles it sat out.
+  int64_t const missed = (int64_t)GetSimTime( ) + 1 - _router_idle_since[r];
+  if ( missed > 0 ) {
+    _sched_routers[r]->SkipIdleCycles( missed );
+  }
+  _router_awake[r] = true;
+  _active_routers.push_back( r );
+}
+
 void Network::ReadInputs( )
 {
+  if ( _engine ) {
+    _engine->Run( [this]( int p ) {
+        vector<TimedModule *> const & part = _partitions[p];
+        for ( size_t i = 0; i < part.size( ); ++i ) {
+          part[i]->ReadInputs( );
+        }
+      } );
+    return;
+  }
+  if ( _active_set ) {
+    for ( size_t i = 0; i < _active_routers.size( ); ++i ) {
+      _sched_routers[_active_routers[i]]->ReadInputs( );
+    }
+    for ( size_t i = 0; i < _active_flit_channels.size( ); ++i ) {
+      _flit_channels[_active_flit_channels[i]]->ReadInputs( );
+    }
+    for ( size_t i = 0; i < _active_credit_channels.size( ); ++i ) {
+      _credit_channels[_active_credit_channels[i]]->ReadInputs( );
+    }
+    for ( size_t i = 0; i < _other_modules.size( ); ++i ) {
+      _other_modules[i]->ReadInputs( );
+    }
+    return;
+  }
   for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
       iter != _timed_modules.end();
       ++iter) {
@@ -190,6 +368,25 @@ void Network::ReadInputs( )
 
 void Network::Evaluate( )
 {
+  if ( _engine ) {
+    _engine->Run( [this]( int p ) {
+        vector<TimedModule *> const & part = _partitions[p];
+        for ( size_t i = 0; i < part.size( ); ++i ) {
+          part[i]->Evaluate( );
+        }
+      } );
+    return;
+  }
+  if ( _active_set ) {
+    // Channels have nothing to evaluate.
+    for ( size_t i = 0; i < _active_routers.size( ); ++i ) {
+      _sched_routers[_active_routers[i]]->Evaluate( );
+    }
+    for ( size_t i = 0; i < _other_modules.size( ); ++i ) {
+      _other_modules[i]->Evaluate( );
+    }
+    return;
+  }
   for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
       iter != _timed_modules.end();
       ++iter) {
@@ -199,6 +396,68 @@ void Network::Evaluate( )
 
 void Network::WriteOutputs( )
 {
+  if ( _engine ) {
+    _engine->Run( [this]( int p ) {
+        vector<TimedModule *> const & part = _partitions[p];
+        for ( size_t i = 0; i < part.size( ); ++i ) {
+          part[i]->WriteOutputs( );
+        }
+      } );
+    return;
+  }
+  if ( _active_set ) {
+    int64_t const next_cycle = (int64_t)GetSimTime( ) + 1;
+    size_t kept = 0;
+    for ( size_t i = 0; i < _active_routers.size( ); ++i ) {
+      int const r = _active_routers[i];
+      _sched_routers[r]->WriteOutputs( );
+      if ( _sched_routers[r]->IsIdle( ) ) {
+        _router_awake[r] = false;
+        _router_idle_since[r] = next_cycle;
+      } else {
+        _active_routers[kept++] = r;
+      }
+    }
+    _active_routers.resize( kept );
+
+    size_t kept_flit = 0;
+    for ( size_t i = 0; i < _active_flit_channels.size( ); ++i ) {
+      int const c = _active_flit_channels[i];
+      FlitChannel * const fc = _flit_channels[c];
+      fc->WriteOutputs( );
+      if ( ( _flit_channel_sink[c] >= 0 ) && fc->Receive( ) ) {
+        _WakeRouter( _flit_channel_sink[c] );
+      }
+      if ( fc->IsIdle( ) ) {
+        fc->SetListed( false );
+      } else {
+        _active_flit_channels[kept_flit++] = c;
+      }
+    }
+    _active_flit_channels.resize( kept_flit );
+    size_t kept_credit = 0;
+    for ( size_t i = 0; i < _active_credit_channels.size( ); ++i ) {
+      int const c = _active_credit_channels[i];
+      CreditChannel * const cc = _credit_channels[c];
+      cc->WriteOutputs( );
+      if ( ( _credit_channel_sink[c] >= 0 ) && cc->Receive( ) ) {
+        _WakeRouter( _credit_channel_sink[c] );
+      }
+      if ( cc->IsIdle( ) ) {
+        cc->SetListed( false );
+      } else {
+        _active_credit_channels[kept_credit++] = c;
+      }
+    }
+    _active_credit_channels.resize( kept_credit );
+    for ( size_t i = 0; i < _other_modules.size( ); ++i ) {
+      _other_modules[i]->WriteOutputs( );
+    }
+    if ( _active_routers.size( ) > kept ) {
+      sort( _active_routers.begin( ), _active_routers.end( ) );
+    }
+    return;
+  }
   for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
       iter != _timed_modules.end();
       ++iter) {
@@ -206,6 +465,100 @@ void Network::WriteOutputs( )
   }
 }
 
+bool Network::IsIdle( ) const
+{
+  if ( _active_set ) {
+    // Routers and channels off the worklists are idle.
+    if ( !_active_routers.empty( ) || !_active_flit_channels.empty( ) ||
+         !_active_credit_channels.empty( ) ) {
+      return false;
+    }
+    for ( size_t i = 0; i < _other_modules.size( ); ++i ) {
+      if ( !_other_modules[i]->IsIdle( ) ) {
+        return false;
+      }
+    }
+    return true;
+  }
+  for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
+      iter != _timed_modules.end();
+      ++iter) {
+    if ( !(*iter)->IsIdle( ) ) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Network::SkipIdleCycles( int64_t cycles )
+{
+  if ( _active_set ) {
+    // Sleeping routers catch up when they are woken.
+    for ( size_t i = 0; i < _active_routers.size( ); ++i ) {
+      _sched_routers[_active_routers[i]]->SkipIdleCycles( cycles );
+    }
+    for ( size_t i = 0; i < _other_modules.size( ); ++i ) {
+      _other_modules[i]->SkipIdleCycles( cycles );
+    }
+    return;
+  }
+  for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
+      iter != _timed_modules.end();
+      ++iter) {
+    (*iter)->SkipIdleCycles( cycles );
+  }
+}
+
+bool Network::CanCheckpoint( ) const
+{
+  for ( int r = 0; r < _size; ++r ) {
+    if ( !_routers[r]->CanCheckpoint( ) ) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Network::Checkpoint( CheckpointFile & cp )
+{
+  cp.Check( Name( ) + " routers", _size );
+  cp.Check( Name( ) + " nodes", _nodes );
+  cp.Check( Name( ) + " channels", _channels );
+
+  if ( _active_set && cp.IsSaving( ) ) {
+    // Let sleeping routers catch up on the cycles they sat out, so the saved
+    // state is the same under every engine. They stay asleep; a restored
+    // network starts with all routers awake.
+    int64_t const now = GetSimTime( );
+    for ( size_t r = 0; r < _sched_routers.size( ); ++r ) {
+      if ( !_router_awake[r] && ( now > _router_idle_since[r] ) ) {
+        _sched_routers[r]->SkipIdleCycles( now - _router_idle_since[r] );
+        _router_idle_since[r] = now;
+      }
+    }
+  }
+
+  if ( _active_set && !cp.IsSaving( ) ) {
+    _WakeAll( GetSimTime( ) );
+  }
+
+  for ( int r = 0; r < _size; ++r ) {
+    _routers[r]->Checkpoint( cp );
+  }
+  for ( int s = 0; s < _nodes; ++s ) {
+    _inject[s]->Checkpoint( cp );
+    _inject_cred[s]->Checkpoint( cp );
+  }
+  for ( int d = 0; d < _nodes; ++d ) {
+    _eject[d]->Checkpoint( cp );
+    _eject_cred[d]->Checkpoint( cp );
+  }
+  for ( int c = 0; c < _channels; ++c ) {
+    _chan[c]->Checkpoint( cp );
+    _chan_cred[c]->Checkpoint( cp );
+  }
+}
+
 void Network::WriteFlit( Flit *f, int source )
 {
   assert( ( source >= 0 ) && ( source < _nodes ) );
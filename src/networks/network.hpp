@@ -41,6 +41,7 @@
 #include "channel.hpp"
 #include "config_utils.hpp"
 #include "globals.hpp"
+#include "parallel_engine.hpp"
 
 typedef Channel<Credit> CreditChannel;
 
@@ -64,8 +65,44 @@ protected:
   vector<FlitChannel *> _chan;
   vector<CreditChannel *> _chan_cred;
 
+  // All flit channels (injection, ejection, then internal) share one block
+  // of memory, as do all credit channels, so the per-cycle channel sweep
+  // walks memory in order.
+  FlitChannel * _flit_channel_block;
+  CreditChannel * _credit_channel_block;
+
   deque<TimedModule *> _timed_modules;
 
+  // Multi-threaded cycle engine: routers and channels are split into one
+  // partition per thread and each phase runs over all partitions in parallel.
+  ParallelEngine * _engine;
+  vector<vector<TimedModule *> > _partitions;
+
+  void _Partition( int threads );
+
+  // Active-set scheduling (serial engine, active_set = 1): only routers and
+  // channels on the worklists are processed. A router joins when one of its
+  // input flit or output credit channels delivers something, a channel when
+  // something is sent into it; both leave once they report IsIdle() after
+  // WriteOutputs. Router worklist order follows _sched_routers so that
+  // routers drawing random numbers see the same sequence as a full sweep.
+  bool _active_set;
+  vector<Router *> _sched_routers;
+  vector<int> _active_routers;
+  vector<bool> _router_awake;
+  vector<int64_t> _router_idle_since;
+  vector<FlitChannel *> _flit_channels;
+  vector<int> _flit_channel_sink;
+  vector<int> _active_flit_channels;
+  vector<CreditChannel *> _credit_channels;
+  vector<int> _credit_channel_sink;
+  vector<int> _active_credit_channels;
+  vector<TimedModule *> _other_modules;
+
+  void _InitActiveSet( );
+  void _WakeAll( int64_t now );
+  void _WakeRouter( int r );
+
   virtual void _ComputeSize( const Configuration &config ) = 0;
   virtual void _BuildNet( const Configuration &config ) = 0;
 
@@ -94,6 +131,15 @@ public:
   virtual void Evaluate( );
   virtual void WriteOutputs( );
 
+  // True when no router or channel holds work; SkipIdleCycles() then
+  // advances their internal state as if that many empty cycles had run.
+  bool IsIdle( ) const;
+  void SkipIdleCycles( int64_t cycles );
+
+  // Saves or restores the state of all routers and channels.
+  void Checkpoint( CheckpointFile & cp );
+  bool CanCheckpoint( ) const;
+
   void Display( ostream & os = cout ) const;
   void DumpChannelMap( ostream & os = cout, string const & prefix = "" ) const;
   void DumpNodeMap( ostream & os = cout, string const & prefix = "" ) const;
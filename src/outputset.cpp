@@ -40,7 +40,7 @@
 
 void OutputSet::Clear( )
 {
-  _outputs.clear( );
+  _outputs._size = 0;
 }
 
 void OutputSet::Add( int output_port, int vc, int pri  )
@@ -51,20 +51,32 @@ void OutputSet::Add( int output_port, int vc, int pri  )
 void OutputSet::AddRange( int output_port, int vc_start, int vc_end, int pri )
 {
 
-  sSetElement s;
+  int pos = 0;
+  while ( ( pos < _outputs._size ) && ( _outputs._elements[pos].pri > pri ) ) {
+    ++pos;
+  }
+  if ( ( pos < _outputs._size ) && ( _outputs._elements[pos].pri == pri ) ) {
+    return;
+  }
+  assert( _outputs._size < ElementList::CAPACITY );
+  for ( int i = _outputs._size; i > pos; --i ) {
+    _outputs._elements[i] = _outputs._elements[i-1];
+  }
+
+  sSetElement & s = _outputs._elements[pos];
 
   s.vc_start = vc_start;
   s.vc_end   = vc_end;
   s.pri      = pri;
   s.output_port = output_port;
-  _outputs.insert( s );
+  ++_outputs._size;
 }
 
 //legacy support, for performance, just use GetSet()
 int OutputSet::NumVCs( int output_port ) const
 {
   int total = 0;
-  set<sSetElement>::const_iterator i = _outputs.begin( );
+  ElementList::const_iterator i = _outputs.begin( );
   while(i!=_outputs.end( )){
     if(i->output_port == output_port){
       total += (i->vc_end - i->vc_start + 1);
@@ -76,7 +88,7 @@ int OutputSet::NumVCs( int output_port ) const
 
 bool OutputSet::OutputEmpty( int output_port ) const
 {
-  set<sSetElement>::const_iterator i = _outputs.begin( );
+  ElementList::const_iterator i = _outputs.begin( );
   while(i!=_outputs.end( )){
     if(i->output_port == output_port){
       return false;
@@ -87,7 +99,7 @@ bool OutputSet::OutputEmpty( int output_port ) const
 }
 
 
-const set<OutputSet::sSetElement> & OutputSet::GetSet() const{
+const OutputSet::ElementList & OutputSet::GetSet() const{
   return _outputs;
 }
 
@@ -101,7 +113,7 @@ int OutputSet::GetVC( int output_port, int vc_index, int *pri ) const
   
   if ( pri ) { *pri = -1; }
 
-  set<sSetElement>::const_iterator i = _outputs.begin( );
+  ElementList::const_iterator i = _outputs.begin( );
   while(i!=_outputs.end( )){
     if(i->output_port == output_port){
       range = i->vc_end - i->vc_start + 1;
@@ -128,7 +140,7 @@ bool OutputSet::GetPortVC( int *out_port, int *out_vc ) const
   bool single_output = false;
   int  used_outputs  = 0;
 
-  set<sSetElement>::const_iterator i = _outputs.begin( );
+  ElementList::const_iterator i = _outputs.begin( );
   if(i!=_outputs.end( )){
     used_outputs = i->output_port;
   }
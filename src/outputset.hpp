@@ -28,8 +28,6 @@
 #ifndef _OUTPUTSET_HPP_
 #define _OUTPUTSET_HPP_
 
-#include <set>
-
 class OutputSet {
 
 
@@ -41,6 +39,29 @@ public:
     int output_port;
   };
 
+  // Elements are stored inline, highest priority first. As with the
+  // std::set this replaced, only the first element added at a given
+  // priority is kept.
+  class ElementList {
+  public:
+    typedef sSetElement const * const_iterator;
+
+    ElementList( ) : _size(0) {}
+
+    inline const_iterator begin( ) const { return _elements; }
+    inline const_iterator end( ) const { return _elements + _size; }
+    inline size_t size( ) const { return _size; }
+    inline bool empty( ) const { return _size == 0; }
+
+  private:
+    friend class OutputSet;
+
+    static const int CAPACITY = 4;
+
+    int _size;
+    sSetElement _elements[CAPACITY];
+  };
+
   void Clear( );
   void Add( int output_port, int vc, int pri = 0 );
   void AddRange( int output_port, int vc_start, int vc_end, int pri = 0 );
@@ -48,12 +69,12 @@ public:
   bool OutputEmpty( int output_port ) const;
   int NumVCs( int output_port ) const;
   
-  const set<sSetElement> & GetSet() const;
+  const ElementList & GetSet() const;
 
   int  GetVC( int output_port,  int vc_index, int *pri = 0 ) const;
   bool GetPortVC( int *out_port, int *out_vc ) const;
 private:
-  set<sSetElement> _outputs;
+  ElementList _outputs;
 };
 
 inline bool operator<(const OutputSet::sSetElement & se1, 
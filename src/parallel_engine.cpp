@@ -0,0 +1,87 @@
+/*parallel_engine.cpp
+ *
+ *Fork-join worker pool for the multi-threaded cycle engine
+ *
+ *Phases are short (one simulated cycle's worth of work for a slice of the
+ *network), so workers spin (yielding) briefly on the generation counter before falling
+ *back to sleeping on the condition variable.
+ *
+ */
+
+#include <cassert>
+
+#include "booksim.hpp"
+#include "parallel_engine.hpp"
+
+static int const SPIN_ITERATIONS = 4096;
+
+ParallelEngine::ParallelEngine( int threads )
+  : _threads(threads), _task(NULL), _generation(0), _pending(0), _shutdown(false)
+{
+  assert(_threads >= 1);
+  for ( int id = 1; id < _threads; ++id ) {
+    _workers.push_back(thread(&ParallelEngine::_Worker, this, id));
+  }
+}
+
+ParallelEngine::~ParallelEngine( )
+{
+  {
+    lock_guard<mutex> guard(_lock);
+    _shutdown = true;
+    ++_generation;
+  }
+  _start.notify_all();
+  for ( size_t i = 0; i < _workers.size(); ++i ) {
+    _workers[i].join();
+  }
+}
+
+void ParallelEngine::Run( tTask const & task )
+{
+  if ( _threads == 1 ) {
+    task(0);
+    return;
+  }
+
+  _task = &task;
+  _pending.store(_threads - 1);
+  {
+    lock_guard<mutex> guard(_lock);
+    ++_generation;
+  }
+  _start.notify_all();
+
+  task(0);
+
+  while ( _pending.load() > 0 ) {
+    this_thread::yield();
+  }
+  _task = NULL;
+}
+
+void ParallelEngine::_Worker( int id )
+{
+  unsigned int seen = 0;
+  while ( true ) {
+    int spins = 0;
+    while ( ( _generation.load() == seen ) && ( spins < SPIN_ITERATIONS ) ) {
+      this_thread::yield();
+      ++spins;
+    }
+    if ( _generation.load() == seen ) {
+      unique_lock<mutex> guard(_lock);
+      while ( _generation.load() == seen ) {
+        _start.wait(guard);
+      }
+    }
+    seen = _generation.load();
+
+    if ( _shutdown ) {
+      return;
+    }
+
+    (*_task)(id);
+    --_pending;
+  }
+}
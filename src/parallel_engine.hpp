@@ -0,0 +1,53 @@
+/*parallel_engine.hpp
+ *
+ *A small fork-join worker pool used to evaluate independent partitions of
+ *the simulated system concurrently. Each call to Run() hands one partition
+ *index to every thread (the calling thread takes partition 0) and returns
+ *only after all of them have finished, so back-to-back calls act as a
+ *barrier between simulation phases.
+ *
+ */
+
+#ifndef _PARALLEL_ENGINE_HPP_
+#define _PARALLEL_ENGINE_HPP_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+
+using namespace std;
+
+class ParallelEngine {
+
+public:
+  typedef function<void(int)> tTask;
+
+  ParallelEngine( int threads );
+  ~ParallelEngine( );
+
+  inline int NumThreads( ) const { return _threads; }
+
+  // Runs task(p) for every partition p in [0, NumThreads()) and waits for
+  // all of them to complete.
+  void Run( tTask const & task );
+
+private:
+  void _Worker( int id );
+
+  int _threads;
+  vector<thread> _workers;
+
+  tTask const * _task;
+
+  atomic<unsigned int> _generation;
+  atomic<int> _pending;
+  bool _shutdown;
+
+  mutex _lock;
+  condition_variable _start;
+};
+
+#endif
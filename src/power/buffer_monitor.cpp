@@ -28,6 +28,7 @@
 #include "buffer_monitor.hpp"
 
 #include "flit.hpp"
+#include "checkpoint.hpp"
 
 BufferMonitor::BufferMonitor( int inputs, int classes ) 
 : _cycles(0), _inputs(inputs), _classes(classes) {
@@ -41,6 +42,12 @@ int BufferMonitor::index( int input, int cl ) const {
   return cl + _classes * input ;
 }
 
+void BufferMonitor::Checkpoint(CheckpointFile & cp) {
+  cp.Io(_cycles);
+  cp.Io(_reads);
+  cp.Io(_writes);
+}
+
 void BufferMonitor::cycle() {
   _cycles++ ;
 }
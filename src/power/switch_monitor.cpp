@@ -28,6 +28,7 @@
 #include "switch_monitor.hpp"
 
 #include "flit.hpp"
+#include "checkpoint.hpp"
 
 SwitchMonitor::SwitchMonitor( int inputs, int outputs, int classes )
 : _cycles(0), _inputs(inputs), _outputs(outputs), _classes(classes) {
@@ -41,6 +42,11 @@ int SwitchMonitor::index( int input, int output, int cl ) const {
   return cl + _classes * ( output + _outputs * input ) ;
 }
 
+void SwitchMonitor::Checkpoint(CheckpointFile & cp) {
+  cp.Io(_cycles);
+  cp.Io(_event);
+}
+
 void SwitchMonitor::cycle() {
   _cycles++ ;
 }
@@ -34,6 +34,7 @@
 using namespace std;
 
 class Flit;
+class CheckpointFile;
 
 class SwitchMonitor {
   int  _cycles ;
@@ -59,6 +60,7 @@ public:
   }
   void traversal( int input, int output, Flit const * f ) ;
   void display(ostream & os) const;
+  void Checkpoint(CheckpointFile & cp);
 } ;
 
 ostream & operator<<( ostream & os, SwitchMonitor const & obj ) ;
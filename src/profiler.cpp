@@ -0,0 +1,158 @@
+/*profiler.cpp
+ *
+ *Per-phase wall time and call counts
+ *
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+#include <mutex>
+
+#include "booksim.hpp"
+#include "profiler.hpp"
+
+namespace {
+
+struct Counters {
+  int64_t nanoseconds[Profiler::NUM_PHASES];
+  int64_t calls[Profiler::NUM_PHASES];
+  int64_t cycles;
+  int64_t flits;
+};
+
+char const * const PHASE_NAMES[Profiler::NUM_PHASES] = {
+  "endpoint receive", "endpoint inject", "endpoint process received",
+  "router input queuing", "router route", "router VC alloc",
+  "router SW alloc", "router switch", "router output",
+  "channel propagation", "SWM coroutine resume"
+};
+
+// One set of counters per thread that has recorded anything; they outlive
+// the threads so that Report() can add them up.
+mutex gCountersLock;
+vector<Counters *> gAllCounters;
+
+Counters & LocalCounters( )
+{
+  static thread_local Counters * counters = NULL;
+  if ( !counters ) {
+    counters = new Counters( );
+    lock_guard<mutex> guard( gCountersLock );
+    gAllCounters.push_back( counters );
+  }
+  return *counters;
+}
+
+}
+
+bool Profiler::_enabled = false;
+bool Profiler::_timing = false;
+bool Profiler::_drain_marked = false;
+int64_t Profiler::_window_cycles = 0;
+int64_t Profiler::_window_flits = 0;
+chrono::steady_clock::time_point Profiler::_drain_start;
+
+void Profiler::Enable( int level )
+{
+  _enabled = ( level > 0 );
+  _timing = ( level > 1 );
+}
+
+void Profiler::Add( Phase phase, int64_t nanoseconds )
+{
+  Counters & c = LocalCounters( );
+  c.nanoseconds[phase] += nanoseconds;
+  ++c.calls[phase];
+}
+
+void Profiler::AddCycles( int64_t cycles )
+{
+  LocalCounters( ).cycles += cycles;
+}
+
+void Profiler::AddFlits( int64_t flits )
+{
+  LocalCounters( ).flits += flits;
+}
+
+void Profiler::MarkDrain( )
+{
+  if ( !_enabled ) {
+    return;
+  }
+  lock_guard<mutex> guard( gCountersLock );
+  _window_cycles = 0;
+  _window_flits = 0;
+  for ( size_t i = 0; i < gAllCounters.size( ); ++i ) {
+    _window_cycles += gAllCounters[i]->cycles;
+    _window_flits += gAllCounters[i]->flits;
+  }
+  _drain_start = chrono::steady_clock::now( );
+  _drain_marked = true;
+}
+
+void Profiler::Reset( )
+{
+  lock_guard<mutex> guard( gCountersLock );
+  for ( size_t i = 0; i < gAllCounters.size( ); ++i ) {
+    *gAllCounters[i] = Counters( );
+  }
+  _drain_marked = false;
+}
+
+void Profiler::Report( ostream & os, double seconds )
+{
+  Counters total = Counters( );
+  {
+    lock_guard<mutex> guard( gCountersLock );
+    for ( size_t i = 0; i < gAllCounters.size( ); ++i ) {
+      for ( int p = 0; p < NUM_PHASES; ++p ) {
+        total.nanoseconds[p] += gAllCounters[i]->nanoseconds[p];
+        total.calls[p] += gAllCounters[i]->calls[p];
+      }
+      total.cycles += gAllCounters[i]->cycles;
+      total.flits += gAllCounters[i]->flits;
+    }
+  }
+
+  ios::fmtflags const flags = os.flags( );
+  streamsize const precision = os.precision( );
+
+  os << "====== Profile ======" << endl;
+  if ( _timing ) {
+    os << left << setw( 28 ) << "phase" << right << setw( 12 ) << "seconds"
+       << setw( 8 ) << "%" << setw( 14 ) << "calls" << setw( 12 ) << "ns/call" << endl;
+    for ( int p = 0; p < NUM_PHASES; ++p ) {
+      if ( total.calls[p] == 0 ) {
+        continue;
+      }
+      double const phase_seconds = total.nanoseconds[p] / 1e9;
+      os << left << setw( 28 ) << PHASE_NAMES[p] << right << fixed
+         << setw( 12 ) << setprecision( 4 ) << phase_seconds
+         << setw( 8 ) << setprecision( 1 ) << 100.0 * phase_seconds / seconds
+         << setw( 14 ) << total.calls[p]
+         << setw( 12 ) << setprecision( 1 ) << (double)total.nanoseconds[p] / total.calls[p]
+         << endl;
+    }
+  }
+  os.flags( flags );
+  os.precision( precision );
+  os << "Simulated cycles = " << total.cycles
+     << " (" << total.cycles / seconds << " cycles/s)" << endl;
+  os << "Delivered flits = " << total.flits
+     << " (" << total.flits / seconds << " flits/s)" << endl;
+
+  // Report() follows the end of the run, so the drain took until now.
+  if ( _drain_marked ) {
+    double const drain_seconds = min( seconds, chrono::duration_cast<chrono::nanoseconds>(
+                                        chrono::steady_clock::now( ) - _drain_start ).count( ) / 1e9 );
+    double const window_seconds = seconds - drain_seconds;
+    os << "Measured window = " << _window_cycles << " cycles, " << _window_flits
+       << " flits, " << window_seconds << " s ("
+       << _window_cycles / window_seconds << " cycles/s, "
+       << _window_flits / window_seconds << " flits/s)" << endl;
+    os << "Drain = " << total.cycles - _window_cycles << " cycles, "
+       << total.flits - _window_flits << " flits, " << drain_seconds << " s" << endl;
+  }
+}
@@ -0,0 +1,88 @@
+/*profiler.hpp
+ *
+ *Wall-clock self-profiling of the simulator. With profile = 1 only the
+ *simulated cycles and delivered flits are counted, which is cheap enough for
+ *benchmarking. With profile = 2, every PROFILE_PHASE scope also adds its
+ *elapsed time and one call to its phase. Times are inclusive: a phase
+ *entered from inside another is counted in both. Each thread of the parallel
+ *engine accumulates separately and Report() adds them up, so with
+ *sim_threads > 1 a phase's time is thread time, not wall time. When the
+ *traffic manager starts draining, the totals so far are kept so that the
+ *measured window and the drain, whose length varies, are reported apart.
+ *
+ *Without phase timing a scope costs one test of a global flag.
+ *
+ */
+
+#ifndef _PROFILER_HPP_
+#define _PROFILER_HPP_
+
+#include <iostream>
+#include <chrono>
+#include <stdint.h>
+
+using namespace std;
+
+class Profiler {
+
+public:
+  enum Phase { ENDPOINT_RECEIVE, ENDPOINT_INJECT, ENDPOINT_PROCESS,
+               ROUTER_INPUT, ROUTER_ROUTE, ROUTER_VC_ALLOC, ROUTER_SW_ALLOC,
+               ROUTER_SWITCH, ROUTER_OUTPUT, CHANNEL, SWM_RESUME,
+               NUM_PHASES };
+
+  static inline bool Enabled( ) { return _enabled; }
+  static inline bool Timing( ) { return _timing; }
+  // 0 = off, 1 = cycle and flit rates, 2 = rates and per-phase times
+  static void Enable( int level );
+
+  static void Add( Phase phase, int64_t nanoseconds );
+
+  // Simulated cycles and delivered flits, for the rates in the report.
+  static void AddCycles( int64_t cycles );
+  static void AddFlits( int64_t flits );
+
+  // Marks the end of the measured window, i.e. the start of the drain; the
+  // report then also gives the rates of the window and of the drain.
+  static void MarkDrain( );
+
+  // Zeroes every thread's counters, e.g. in a sweep point forked after the
+  // shared warm-up.
+  static void Reset( );
+
+  // Prints the rates, and the per-phase table if timing, for a run that took the given wall time.
+  static void Report( ostream & os, double seconds );
+
+private:
+  static bool _enabled;
+  static bool _timing;
+  static bool _drain_marked;
+  static int64_t _window_cycles;
+  static int64_t _window_flits;
+  static chrono::steady_clock::time_point _drain_start;
+};
+
+class ProfileScope {
+
+public:
+  inline ProfileScope( Profiler::Phase phase ) : _phase( phase ), _on( Profiler::Timing( ) ) {
+    if ( _on ) {
+      _start = chrono::steady_clock::now( );
+    }
+  }
+  inline ~ProfileScope( ) {
+    if ( _on ) {
+      Profiler::Add( _phase, chrono::duration_cast<chrono::nanoseconds>(
+                       chrono::steady_clock::now( ) - _start ).count( ) );
+    }
+  }
+
+private:
+  Profiler::Phase _phase;
+  bool _on;
+  chrono::steady_clock::time_point _start;
+};
+
+#define PROFILE_PHASE( phase ) ProfileScope _profile_scope( Profiler::phase )
+
+#endif
@@ -26,13 +26,53 @@
 */
 
 #include "random_utils.hpp"
+#include "checkpoint.hpp"
 #include <algorithm>
 #include <cassert>
+#include <mutex>
 
 extern long ran_x[];
 extern double ran_u[];
 #define KK 100
 
+#define QUALITY 1009
+extern long ran_arr_buf[];
+extern long ran_arr_dummy, ran_arr_started;
+extern long * ran_arr_ptr;
+extern double ranf_arr_buf[];
+extern double ranf_arr_dummy, ranf_arr_started;
+extern double * ranf_arr_ptr;
+
+bool gRandomThreadSafe = false;
+static std::mutex random_lock;
+
+bool gRandomStreams = false;
+uint64_t gRandomStreamKey = 0;
+thread_local RandomStream * gCurrentRandomStream = NULL;
+
+void RandomStream::SetId( std::string const & name ) {
+  // FNV-1a, so that a module keeps its stream when others are added
+  _id = 14695981039346656037ULL;
+  for ( size_t i = 0; i < name.size( ); ++i ) {
+    _id = ( _id ^ (unsigned char)name[i] ) * 1099511628211ULL;
+  }
+  _counter = 0;
+}
+
+void RandomSetThreadSafe( bool thread_safe ) {
+  gRandomThreadSafe = thread_safe;
+}
+
+long ran_next_locked( ) {
+  std::lock_guard<std::mutex> guard(random_lock);
+  return ran_next( );
+}
+
+double ranf_next_locked( ) {
+  std::lock_guard<std::mutex> guard(random_lock);
+  return ranf_next( );
+}
+
 void SaveRandomState( std::vector<long> & save_x, std::vector<double> & save_u ) {
   save_x.assign(ran_x, ran_x + KK);
   save_u.assign(ran_u, ran_u + KK);
@@ -44,3 +84,29 @@ void RestoreRandomState( std::vector<long> const & save_x, std::vector<double> c
   assert(save_u.size() == KK);
   std::copy(save_u.begin(), save_u.end(), ran_u);
 }
+
+// The read pointer of a generator either points into its output buffer or
+// at one of two sentinels (not seeded / seeded but no numbers drawn yet).
+template<class T>
+static void CheckpointStream( CheckpointFile & cp, T * state, T * buf,
+                              T * & ptr, T * dummy, T * started ) {
+  for ( int i = 0; i < KK; ++i ) {
+    cp.Io( state[i] );
+  }
+  for ( int i = 0; i < QUALITY; ++i ) {
+    cp.Io( buf[i] );
+  }
+  int64_t pos = ( ptr == dummy ) ? -1 : ( ptr == started ) ? -2 : ( ptr - buf );
+  cp.Io( pos );
+  if ( !cp.IsSaving( ) ) {
+    if ( ( pos < -2 ) || ( pos >= QUALITY ) ) {
+      cp.Error( "invalid random generator state" );
+    }
+    ptr = ( pos == -1 ) ? dummy : ( pos == -2 ) ? started : ( buf + pos );
+  }
+}
+
+void CheckpointRandomState( CheckpointFile & cp ) {
+  CheckpointStream( cp, ran_x, ran_arr_buf, ran_arr_ptr, &ran_arr_dummy, &ran_arr_started );
+  CheckpointStream( cp, ran_u, ranf_arr_buf, ranf_arr_ptr, &ranf_arr_dummy, &ranf_arr_started );
+}
@@ -29,6 +29,8 @@
 #define _RANDOM_UTILS_HPP_
 
 #include <vector>
+#include <string>
+#include <stdint.h>
 
 // interface to Knuth's RANARRAY RNG
 void   ran_start(long seed);
@@ -36,27 +38,100 @@ long   ran_next( );
 void   ranf_start(long seed);
 double ranf_next( );
 
+// The generator is shared by every module. When modules are evaluated on
+// multiple threads, draws are serialized through a lock.
+extern bool gRandomThreadSafe;
+void   RandomSetThreadSafe( bool thread_safe );
+long   ran_next_locked( );
+double ranf_next_locked( );
+
+// Counter-based random stream of one module. The n-th number drawn is a hash
+// of the global seed, the module's name and n, so it does not depend on what
+// other modules drew before, or on the order in which modules are evaluated.
+extern uint64_t gRandomStreamKey;
+
+class RandomStream {
+public:
+  RandomStream( ) : _id( 0 ), _counter( 0 ) { }
+
+  void SetId( std::string const & name );
+
+  inline uint64_t Next( ) {
+    return Mix( ( gRandomStreamKey ^ _id ) + ++_counter * 0x9e3779b97f4a7c15ULL );
+  }
+
+  // number of values drawn so far, for checkpointing
+  inline uint64_t & Counter( ) { return _counter; }
+
+  static inline uint64_t Mix( uint64_t z ) {
+    z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ULL;
+    z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebULL;
+    return z ^ ( z >> 31 );
+  }
+
+private:
+  uint64_t _id;
+  uint64_t _counter;
+};
+
+// With random_streams enabled, routers and endpoints make their stream current
+// while they are evaluated and all draws come from it; otherwise, and outside
+// of such modules, draws come from the shared generator.
+extern bool gRandomStreams;
+extern thread_local RandomStream * gCurrentRandomStream;
+
+class RandomStreamScope {
+public:
+  inline RandomStreamScope( RandomStream * stream ) : _saved( gCurrentRandomStream ) {
+    if ( gRandomStreams ) {
+      gCurrentRandomStream = stream;
+    }
+  }
+  inline ~RandomStreamScope( ) {
+    gCurrentRandomStream = _saved;
+  }
+
+private:
+  RandomStream * _saved;
+};
+
 inline void RandomSeed( long seed ) {
   ran_start( seed );
   ranf_start( seed );
+  gRandomStreamKey = RandomStream::Mix( seed );
+}
+
+inline long RandomNext( ) {
+  if ( gCurrentRandomStream ) {
+    // 30 bits, the range of ran_next()
+    return gCurrentRandomStream->Next( ) >> 34;
+  }
+  return gRandomThreadSafe ? ran_next_locked( ) : ran_next( );
+}
+
+inline double RandomNextFloat( ) {
+  if ( gCurrentRandomStream ) {
+    return ( gCurrentRandomStream->Next( ) >> 11 ) * ( 1.0 / 9007199254740992.0 );
+  }
+  return gRandomThreadSafe ? ranf_next_locked( ) : ranf_next( );
 }
 
 inline unsigned long RandomIntLong( ) {
-  return ran_next( );
+  return RandomNext( );
 }
 
 // Returns a random integer in the range [0,max]
 inline int RandomInt( int max ) {
-  return ( ran_next( ) % (max+1) );
+  return ( RandomNext( ) % (max+1) );
 }
 
 // Returns a random floating-point value in the rage [0,1]
-inline double RandomFloat(  ) { return ranf_next( );
+inline double RandomFloat(  ) { return RandomNextFloat( );
 }
 
 // Returns a random floating-point value in the rage [0,max]
 inline double RandomFloat( double max ) {
-  return ( ranf_next( ) * max );
+  return ( RandomNextFloat( ) * max );
 }
 
 // Saves the current generator state
@@ -65,4 +140,11 @@ void SaveRandomState( std::vector<long> & save_x, std::vector<double> & save_u )
 // Restores the generator state from previously saved values
 void RestoreRandomState( std::vector<long> const & save_x, std::vector<double> const & save_u );
 
+class CheckpointFile;
+
+// Saves or restores the complete state of both generators, including the
+// numbers already generated but not yet handed out, so that a restored
+// simulation continues the exact same random sequence
+void CheckpointRandomState( CheckpointFile & cp );
+
 #endif
@@ -46,6 +46,7 @@
 #include "allocator.hpp"
 #include "switch_monitor.hpp"
 #include "buffer_monitor.hpp"
+#include "profiler.hpp"
 
 IQRouter::IQRouter( Configuration const & config, Module *parent,
 		    string const & name, int id, int inputs, int outputs )
@@ -288,6 +289,24 @@ void IQRouter::WriteOutputs( )
   _SendCredits( );
 }
 
+bool IQRouter::IsIdle( ) const
+{
+  if ( _active ) {
+    return false;
+  }
+  for ( int output = 0; output < _outputs; ++output ) {
+    if ( !_output_buffer[output].empty( ) ) {
+      return false;
+    }
+  }
+  for ( int input = 0; input < _inputs; ++input ) {
+    if ( !_credit_buffer[input].empty( ) ) {
+      return false;
+    }
+  }
+  return true;
+}
+
 
 //------------------------------------------------------------------------------
 // read inputs
@@ -295,6 +314,7 @@ void IQRouter::WriteOutputs( )
 
 bool IQRouter::_ReceiveFlits( )
 {
+  PROFILE_PHASE( ROUTER_INPUT );
   bool activity = false;
   for(int input = 0; input < _inputs; ++input) {
     Flit * const f = _input_channels[input]->Receive();
@@ -319,6 +339,7 @@ bool IQRouter::_ReceiveFlits( )
 
 bool IQRouter::_ReceiveCredits( )
 {
+  PROFILE_PHASE( ROUTER_INPUT );
   bool activity = false;
   for(int output = 0; output < _outputs; ++output) {
     Credit * const c = _output_credits[output]->Receive();
@@ -338,6 +359,7 @@ bool IQRouter::_ReceiveCredits( )
 
 void IQRouter::_InputQueuing( )
 {
+  PROFILE_PHASE( ROUTER_INPUT );
   for(map<int, Flit *>::const_iterator iter = _in_queue_flits.begin();
       iter != _in_queue_flits.end();
       ++iter) {
@@ -439,7 +461,7 @@ void IQRouter::_InputQueuing( )
     BufferState * const dest_buf = _next_buf[output];
 
 #ifdef TRACK_FLOWS
-    for(set<int>::const_iterator iter = c->vc.begin(); iter != c->vc.end(); ++iter) {
+    for(Credit::VCSet::const_iterator iter = c->vc.begin(); iter != c->vc.end(); ++iter) {
       int const vc = *iter;
       assert(!_outstanding_classes[output][vc].empty());
       int cl = _outstanding_classes[output][vc].front();
@@ -462,6 +484,7 @@ void IQRouter::_InputQueuing( )
 
 void IQRouter::_RouteEvaluate( )
 {
+  PROFILE_PHASE( ROUTER_ROUTE );
   assert(_routing_delay);
 
   for(deque<pair<int, pair<int, int> > >::iterator iter = _route_vcs.begin();
@@ -500,6 +523,7 @@ void IQRouter::_RouteEvaluate( )
 
 void IQRouter::_RouteUpdate( )
 {
+  PROFILE_PHASE( ROUTER_ROUTE );
   assert(_routing_delay);
 
   while(!_route_vcs.empty()) {
@@ -554,6 +578,7 @@ void IQRouter::_RouteUpdate( )
 
 void IQRouter::_VCAllocEvaluate( )
 {
+  PROFILE_PHASE( ROUTER_VC_ALLOC );
   assert(_vc_allocator);
 
   bool watched = false;
@@ -595,7 +620,7 @@ void IQRouter::_VCAllocEvaluate( )
     assert(route_set);
 
     int const out_priority = cur_buf->GetPriority(vc);
-    set<OutputSet::sSetElement> const setlist = route_set->GetSet();
+    OutputSet::ElementList const & setlist = route_set->GetSet();
 
     bool elig = false;
     bool cred = false;
@@ -603,7 +628,7 @@ void IQRouter::_VCAllocEvaluate( )
 
     assert(!_noq || (setlist.size() == 1));
 
-    for(set<OutputSet::sSetElement>::const_iterator iset = setlist.begin();
+    for(OutputSet::ElementList::const_iterator iset = setlist.begin();
 	iset != setlist.end();
 	++iset) {
 
@@ -841,6 +866,7 @@ void IQRouter::_VCAllocEvaluate( )
 
 void IQRouter::_VCAllocUpdate( )
 {
+  PROFILE_PHASE( ROUTER_VC_ALLOC );
   assert(_vc_allocator);
 
   while(!_vc_alloc_vcs.empty()) {
@@ -932,6 +958,7 @@ void IQRouter::_VCAllocUpdate( )
 
 void IQRouter::_SWHoldEvaluate( )
 {
+  PROFILE_PHASE( ROUTER_SW_ALLOC );
   assert(_hold_switch_for_packet);
 
   for(deque<pair<int, pair<pair<int, int>, int> > >::iterator iter = _sw_hold_vcs.begin();
@@ -1006,6 +1033,7 @@ void IQRouter::_SWHoldEvaluate( )
 
 void IQRouter::_SWHoldUpdate( )
 {
+  PROFILE_PHASE( ROUTER_SW_ALLOC );
   assert(_hold_switch_for_packet);
 
   while(!_sw_hold_vcs.empty()) {
@@ -1328,6 +1356,7 @@ bool IQRouter::_SWAllocAddReq(int input, int vc, int output)
 
 void IQRouter::_SWAllocEvaluate( )
 {
+  PROFILE_PHASE( ROUTER_SW_ALLOC );
   bool watched = false;
 
   for(deque<pair<int, pair<pair<int, int>, int> > >::iterator iter = _sw_alloc_vcs.begin();
@@ -1399,11 +1428,11 @@ void IQRouter::_SWAllocEvaluate( )
     OutputSet const * const route_set = cur_buf->GetRouteSet(vc);
     assert(route_set);
 
-    set<OutputSet::sSetElement> const setlist = route_set->GetSet();
+    OutputSet::ElementList const & setlist = route_set->GetSet();
 
     assert(!_noq || (setlist.size() == 1));
 
-    for(set<OutputSet::sSetElement>::const_iterator iset = setlist.begin();
+    for(OutputSet::ElementList::const_iterator iset = setlist.begin();
 	iset != setlist.end();
 	++iset) {
 
@@ -1743,7 +1772,7 @@ void IQRouter::_SWAllocEvaluate( )
 	  OutputSet const * const route_set = cur_buf->GetRouteSet(vc);
 	  assert(route_set);
 
-	  set<OutputSet::sSetElement> const setlist = route_set->GetSet();
+	  OutputSet::ElementList const & setlist = route_set->GetSet();
 
 	  bool busy = true;
 	  bool full = true;
@@ -1751,7 +1780,7 @@ void IQRouter::_SWAllocEvaluate( )
 
 	  assert(!_noq || (setlist.size() == 1));
 
-	  for(set<OutputSet::sSetElement>::const_iterator iset = setlist.begin();
+	  for(OutputSet::ElementList::const_iterator iset = setlist.begin();
 	      iset != setlist.end();
 	      ++iset) {
 	    if(iset->output_port == output) {
@@ -1837,6 +1866,7 @@ void IQRouter::_SWAllocEvaluate( )
 
 void IQRouter::_SWAllocUpdate( )
 {
+  PROFILE_PHASE( ROUTER_SW_ALLOC );
   while(!_sw_alloc_vcs.empty()) {
 
     pair<int, pair<pair<int, int>, int> > const & item = _sw_alloc_vcs.front();
@@ -1898,11 +1928,11 @@ void IQRouter::_SWAllocUpdate( )
 	int match_prio = numeric_limits<int>::min();
 
 	const OutputSet * route_set = cur_buf->GetRouteSet(vc);
-	set<OutputSet::sSetElement> const setlist = route_set->GetSet();
+	OutputSet::ElementList const & setlist = route_set->GetSet();
 
 	assert(!_noq || (setlist.size() == 1));
 
-	for(set<OutputSet::sSetElement>::const_iterator iset = setlist.begin();
+	for(OutputSet::ElementList::const_iterator iset = setlist.begin();
 	    iset != setlist.end();
 	    ++iset) {
 	  if(iset->output_port == output) {
@@ -2136,6 +2166,7 @@ void IQRouter::_SWAllocUpdate( )
 
 void IQRouter::_SwitchEvaluate( )
 {
+  PROFILE_PHASE( ROUTER_SWITCH );
   for(deque<pair<int, pair<Flit *, pair<int, int> > > >::iterator iter = _crossbar_flits.begin();
       iter != _crossbar_flits.end();
       ++iter) {
@@ -2166,6 +2197,7 @@ void IQRouter::_SwitchEvaluate( )
 
 void IQRouter::_SwitchUpdate( )
 {
+  PROFILE_PHASE( ROUTER_SWITCH );
   while(!_crossbar_flits.empty()) {
 
     pair<int, pair<Flit *, pair<int, int> > > const & item = _crossbar_flits.front();
@@ -2203,7 +2235,7 @@ void IQRouter::_SwitchUpdate( )
 		 << " at output " << output
 		 << "." << endl;
     }
-    _output_buffer[output].push(f);
+    _output_buffer[output].push(f->GetHandle());
     //the output buffer size isn't precise due to flits in flight
     //but there is a maximum bound based on output speed up and ST traversal
     assert(_output_buffer[output].size()<=(size_t)_output_buffer_size+ _crossbar_delay* _output_speedup+( _output_speedup-1) ||_output_buffer_size==-1);
@@ -2218,6 +2250,7 @@ void IQRouter::_SwitchUpdate( )
 
 void IQRouter::_OutputQueuing( )
 {
+  PROFILE_PHASE( ROUTER_OUTPUT );
   for(map<int, Credit *>::const_iterator iter = _out_queue_credits.begin();
       iter != _out_queue_credits.end();
       ++iter) {
@@ -2240,9 +2273,10 @@ void IQRouter::_OutputQueuing( )
 
 void IQRouter::_SendFlits( )
 {
+  PROFILE_PHASE( ROUTER_OUTPUT );
   for ( int output = 0; output < _outputs; ++output ) {
     if ( !_output_buffer[output].empty( ) ) {
-      Flit * const f = _output_buffer[output].front( );
+      Flit * const f = Flit::FromHandle(_output_buffer[output].front( ));
       assert(f);
       _output_buffer[output].pop( );
 
@@ -2265,6 +2299,7 @@ void IQRouter::_SendFlits( )
 
 void IQRouter::_SendCredits( )
 {
+  PROFILE_PHASE( ROUTER_OUTPUT );
   for ( int input = 0; input < _inputs; ++input ) {
     if ( !_credit_buffer[input].empty( ) ) {
       Credit * const c = _credit_buffer[input].front( );
@@ -2352,7 +2387,7 @@ void IQRouter::_UpdateNOQ(int input, int vc, Flit const * f) {
   assert(f);
   assert(f->vc == vc);
   assert(f->head);
-  set<OutputSet::sSetElement> sl = f->la_route_set.GetSet();
+  OutputSet::ElementList sl = f->la_route_set.GetSet();
   assert(sl.size() == 1);
   int out_port = sl.begin()->output_port;
   const FlitChannel * channel = _output_channels[out_port];
@@ -93,7 +93,7 @@ class IQRouter : public Router {
   tRoutingFunction   _rf;
 
   int _output_buffer_size;
-  vector<queue<Flit *> > _output_buffer;
+  vector<queue<Flit::Handle> > _output_buffer;
 
   vector<queue<Credit *> > _credit_buffer;
 
@@ -161,6 +161,8 @@ public:
   virtual void ReadInputs( );
   virtual void WriteOutputs( );
 
+  virtual bool IsIdle( ) const;
+
   void Display( ostream & os = cout ) const;
 
   virtual int GetUsedCredit(int o) const;
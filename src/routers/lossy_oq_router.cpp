@@ -44,6 +44,7 @@
 #include "buffer_state.hpp"
 #include "switch_monitor.hpp"
 #include "buffer_monitor.hpp"
+#include "profiler.hpp"
 
 LossyOQRouter::LossyOQRouter( Configuration const & config, Module *parent,
 		    string const & name, int id, int inputs, int outputs )
@@ -112,6 +113,7 @@ LossyOQRouter::LossyOQRouter( Configuration const & config, Module *parent,
 
 
   _random_packet_drop_rate = config.GetFloat( "switch_drop_rate" );
+  _dropped_flits = 0;
 
   // Initialize the state to drop incoming flits of a multi-flit packet.  The
   // decision to drop is made when the head flit is received.  This state is
@@ -193,6 +195,75 @@ void LossyOQRouter::WriteOutputs( )
   _SendCredits( );
 }
 
+bool LossyOQRouter::IsIdle( ) const
+{
+  if ( _active ) {
+    return false;
+  }
+  for ( int output = 0; output < _outputs; ++output ) {
+    if ( !_output_buffer[output].empty( ) ) {
+      return false;
+    }
+  }
+  for ( int input = 0; input < _inputs; ++input ) {
+    if ( !_credit_buffer[input].empty( ) ) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+void LossyOQRouter::_Checkpoint( CheckpointFile & cp )
+{
+  cp.Check( FullName( ) + " vcs", _vcs );
+
+  cp.Io( _active );
+  cp.Io( _in_queue_flits );
+  cp.Io( _proc_credits );
+  cp.Io( _crossbar_flits );
+  cp.Io( _out_queue_credits );
+  for ( int i = 0; i < _inputs; ++i ) {
+    _buf[i]->Checkpoint( cp );
+  }
+  for ( int j = 0; j < _outputs; ++j ) {
+    _next_buf[j]->Checkpoint( cp );
+  }
+  cp.Io( _last_head_flit_output_port );
+  cp.Io( _output_buffer );
+  cp.Io( _current_pid_output_in_progress );
+  cp.Io( _credit_buffer );
+  cp.Io( _total_buffer_occupancy );
+  cp.Io( _output_buffer_occupancy );
+
+  // Insertion points are saved as positions in their output queue, with
+  // end() (or an iterator whose element has already left) as the length.
+  for ( int output = 0; output < _outputs; ++output ) {
+    list<Flit *> & queue = _output_buffer[output];
+    for ( int input = 0; input < _inputs; ++input ) {
+      list<Flit *>::iterator & insertion = _oq_insertion_iters[output][input];
+      int pos = 0;
+      if ( cp.IsSaving( ) ) {
+        list<Flit *>::iterator iter = queue.begin( );
+        while ( ( iter != queue.end( ) ) && ( iter != insertion ) ) {
+          ++iter;
+          ++pos;
+        }
+      }
+      cp.Io( pos );
+      if ( !cp.IsSaving( ) ) {
+        insertion = queue.begin( );
+        advance( insertion, pos );
+      }
+    }
+  }
+  cp.Io( _input_insertion_pointing_at_output_buffer_head );
+  cp.Io( _drop_packet_at_input );
+  cp.Io( _dropped_flits );
+
+  _bufferMonitor->Checkpoint( cp );
+  _switchMonitor->Checkpoint( cp );
+}
 
 //------------------------------------------------------------------------------
 // read inputs
@@ -200,6 +271,7 @@ void LossyOQRouter::WriteOutputs( )
 
 bool LossyOQRouter::_ReceiveFlits( )
 {
+  PROFILE_PHASE( ROUTER_INPUT );
   bool activity = false;
   for(int input = 0; input < _inputs; ++input) {
     Flit * const f = _input_channels[input]->Receive();
@@ -227,6 +299,7 @@ bool LossyOQRouter::_ReceiveFlits( )
 
 bool LossyOQRouter::_ReceiveCredits( )
 {
+  PROFILE_PHASE( ROUTER_INPUT );
   bool activity = false;
   for(int output = 0; output < _outputs; ++output) {
     Credit * const c = _output_credits[output]->Receive();
@@ -246,6 +319,7 @@ bool LossyOQRouter::_ReceiveCredits( )
 
 void LossyOQRouter::_InputQueuing( )
 {
+  PROFILE_PHASE( ROUTER_INPUT );
   for(map<int, Flit *>::const_iterator iter = _in_queue_flits.begin();
       iter != _in_queue_flits.end();
       ++iter) {
@@ -305,7 +379,7 @@ void LossyOQRouter::_InputQueuing( )
 
       OutputSet route_set_container;
       _rf( this, f, input, &route_set_container, false );
-      set<OutputSet::sSetElement> const & route_set = route_set_container.GetSet();
+      OutputSet::ElementList const & route_set = route_set_container.GetSet();
       assert(route_set.size() == 1);
       OutputSet::sSetElement const & route_set_element = *route_set.begin();
       assert(route_set_element.output_port != -1);
@@ -353,6 +427,7 @@ void LossyOQRouter::_InputQueuing( )
         }
 
         --_total_buffer_occupancy;
+        ++_dropped_flits;
 
         cur_buf->RemoveFlit(vc);
 
@@ -380,6 +455,7 @@ void LossyOQRouter::_InputQueuing( )
         }
 
         --_total_buffer_occupancy;
+        ++_dropped_flits;
 
         cur_buf->RemoveFlit(vc);
 
@@ -437,6 +513,7 @@ void LossyOQRouter::_InputQueuing( )
         }
 
         --_total_buffer_occupancy;
+        ++_dropped_flits;
 
         cur_buf->RemoveFlit(vc);
 
@@ -507,6 +584,7 @@ void LossyOQRouter::_InputQueuing( )
 
 void LossyOQRouter::_SwitchEvaluate( )
 {
+  PROFILE_PHASE( ROUTER_SWITCH );
   for(deque<pair<int, pair<Flit *, pair<int, int> > > >::iterator iter = _crossbar_flits.begin();
       iter != _crossbar_flits.end();
       ++iter) {
@@ -540,6 +618,7 @@ void LossyOQRouter::_SwitchEvaluate( )
 
 void LossyOQRouter::_SwitchUpdate( )
 {
+  PROFILE_PHASE( ROUTER_SWITCH );
   while(!_crossbar_flits.empty()) {
 
     pair<int, pair<Flit *, pair<int, int> > > const & item = _crossbar_flits.front();
@@ -803,6 +882,7 @@ if ((!((_input_insertion_pointing_at_output_buffer_head[output] == input) &&
 
 void LossyOQRouter::_OutputQueuing( )
 {
+  PROFILE_PHASE( ROUTER_OUTPUT );
   for(map<int, Credit *>::const_iterator iter = _out_queue_credits.begin();
       iter != _out_queue_credits.end();
       ++iter) {
@@ -825,6 +905,7 @@ void LossyOQRouter::_OutputQueuing( )
 
 void LossyOQRouter::_SendFlits( )
 {
+  PROFILE_PHASE( ROUTER_OUTPUT );
   for ( int output = 0; output < _outputs; ++output ) {
     if ( !_output_buffer[output].empty( ) ) {
       Flit * const f = _output_buffer[output].front( );
@@ -911,6 +992,7 @@ if ((!f->tail) && (_input_insertion_pointing_at_output_buffer_head[output] != -1
 
 void LossyOQRouter::_SendCredits( )
 {
+  PROFILE_PHASE( ROUTER_OUTPUT );
   for ( int input = 0; input < _inputs; ++input ) {
     if ( !_credit_buffer[input].empty( ) ) {
       Credit * const c = _credit_buffer[input].front( );
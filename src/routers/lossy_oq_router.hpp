@@ -92,12 +92,15 @@ class LossyOQRouter : public Router {
 
   vector<bool> _drop_packet_at_input;
   float _random_packet_drop_rate;
+  int64_t _dropped_flits;
 
   bool _ReceiveFlits( );
   bool _ReceiveCredits( );
 
   virtual void _InternalStep( );
 
+  virtual void _Checkpoint( CheckpointFile & cp );
+
   void _InputQueuing( );
 
   void _SwitchEvaluate( );
@@ -130,10 +133,14 @@ public:
   virtual void ReadInputs( );
   virtual void WriteOutputs( );
 
+  virtual bool IsIdle( ) const;
+  virtual bool CanCheckpoint( ) const { return true; }
+
   void Display( ostream & os = cout ) const;
 
   virtual int GetUsedCredit(int o) const;
   virtual int GetBufferOccupancy(int i) const;
+  virtual int64_t GetDroppedFlits() const { return _dropped_flits; }
 
 #ifdef TRACK_BUFFERS
   virtual int GetUsedCreditForClass(int output, int cl) const;
@@ -46,6 +46,7 @@
 #include "allocator.hpp"
 #include "switch_monitor.hpp"
 #include "buffer_monitor.hpp"
+#include "profiler.hpp"
 
 LossyRouter::LossyRouter( Configuration const & config, Module *parent,
 		    string const & name, int id, int inputs, int outputs )
@@ -177,6 +178,7 @@ LossyRouter::LossyRouter( Configuration const & config, Module *parent,
 
 
   _random_packet_drop_rate = config.GetFloat( "switch_drop_rate" );
+  _dropped_flits = 0;
 
   // Initialize the state to drop incoming flits of a multi-flit packet.  The
   // decision to drop is made when the head flit is received.  This state is
@@ -305,6 +307,24 @@ void LossyRouter::WriteOutputs( )
   _SendCredits( );
 }
 
+bool LossyRouter::IsIdle( ) const
+{
+  if ( _active ) {
+    return false;
+  }
+  for ( int output = 0; output < _outputs; ++output ) {
+    if ( !_output_buffer[output].empty( ) ) {
+      return false;
+    }
+  }
+  for ( int input = 0; input < _inputs; ++input ) {
+    if ( !_credit_buffer[input].empty( ) ) {
+      return false;
+    }
+  }
+  return true;
+}
+
 
 //------------------------------------------------------------------------------
 // read inputs
@@ -312,6 +332,7 @@ void LossyRouter::WriteOutputs( )
 
 bool LossyRouter::_ReceiveFlits( )
 {
+  PROFILE_PHASE( ROUTER_INPUT );
   bool activity = false;
   for(int input = 0; input < _inputs; ++input) {
     Flit * const f = _input_channels[input]->Receive();
@@ -336,6 +357,7 @@ bool LossyRouter::_ReceiveFlits( )
 
 bool LossyRouter::_ReceiveCredits( )
 {
+  PROFILE_PHASE( ROUTER_INPUT );
   bool activity = false;
   for(int output = 0; output < _outputs; ++output) {
     Credit * const c = _output_credits[output]->Receive();
@@ -355,6 +377,7 @@ bool LossyRouter::_ReceiveCredits( )
 
 void LossyRouter::_InputQueuing( )
 {
+  PROFILE_PHASE( ROUTER_INPUT );
   for(map<int, Flit *>::const_iterator iter = _in_queue_flits.begin();
       iter != _in_queue_flits.end();
       ++iter) {
@@ -422,6 +445,8 @@ void LossyRouter::_InputQueuing( )
         _drop_packet_at_input[input] = true;
       }
 
+      ++_dropped_flits;
+
       // Delete the flit object, since it is either a copy of one held in an
       // OPB, or it is a control flit that is just silently dropped.
       f->Free();
@@ -441,6 +466,7 @@ void LossyRouter::_InputQueuing( )
         _drop_packet_at_input[input] = false;
       }
 
+      ++_dropped_flits;
       f->Free();
 
     // If buffer is not full, add the flit normally.
@@ -512,7 +538,7 @@ void LossyRouter::_InputQueuing( )
     BufferState * const dest_buf = _next_buf[output];
 
 #ifdef TRACK_FLOWS
-    for(set<int>::const_iterator iter = c->vc.begin(); iter != c->vc.end(); ++iter) {
+    for(Credit::VCSet::const_iterator iter = c->vc.begin(); iter != c->vc.end(); ++iter) {
       int const vc = *iter;
       assert(!_outstanding_classes[output][vc].empty());
       int cl = _outstanding_classes[output][vc].front();
@@ -535,6 +561,7 @@ void LossyRouter::_InputQueuing( )
 
 void LossyRouter::_RouteEvaluate( )
 {
+  PROFILE_PHASE( ROUTER_ROUTE );
   assert(_routing_delay);
 
   for(deque<pair<int, pair<int, int> > >::iterator iter = _route_vcs.begin();
@@ -573,6 +600,7 @@ void LossyRouter::_RouteEvaluate( )
 
 void LossyRouter::_RouteUpdate( )
 {
+  PROFILE_PHASE( ROUTER_ROUTE );
   assert(_routing_delay);
 
   while(!_route_vcs.empty()) {
@@ -627,6 +655,7 @@ void LossyRouter::_RouteUpdate( )
 
 void LossyRouter::_VCAllocEvaluate( )
 {
+  PROFILE_PHASE( ROUTER_VC_ALLOC );
   assert(_vc_allocator);
 
   bool watched = false;
@@ -668,7 +697,7 @@ void LossyRouter::_VCAllocEvaluate( )
     assert(route_set);
 
     int const out_priority = cur_buf->GetPriority(vc);
-    set<OutputSet::sSetElement> const setlist = route_set->GetSet();
+    OutputSet::ElementList const & setlist = route_set->GetSet();
 
     bool elig = false;
     bool cred = false;
@@ -676,7 +705,7 @@ void LossyRouter::_VCAllocEvaluate( )
 
     assert(!_noq || (setlist.size() == 1));
 
-    for(set<OutputSet::sSetElement>::const_iterator iset = setlist.begin();
+    for(OutputSet::ElementList::const_iterator iset = setlist.begin();
 	iset != setlist.end();
 	++iset) {
 
@@ -914,6 +943,7 @@ void LossyRouter::_VCAllocEvaluate( )
 
 void LossyRouter::_VCAllocUpdate( )
 {
+  PROFILE_PHASE( ROUTER_VC_ALLOC );
   assert(_vc_allocator);
 
   while(!_vc_alloc_vcs.empty()) {
@@ -1005,6 +1035,7 @@ void LossyRouter::_VCAllocUpdate( )
 
 void LossyRouter::_SWHoldEvaluate( )
 {
+  PROFILE_PHASE( ROUTER_SW_ALLOC );
   assert(_hold_switch_for_packet);
 
   for(deque<pair<int, pair<pair<int, int>, int> > >::iterator iter = _sw_hold_vcs.begin();
@@ -1079,6 +1110,7 @@ void LossyRouter::_SWHoldEvaluate( )
 
 void LossyRouter::_SWHoldUpdate( )
 {
+  PROFILE_PHASE( ROUTER_SW_ALLOC );
   assert(_hold_switch_for_packet);
 
   while(!_sw_hold_vcs.empty()) {
@@ -1412,6 +1444,7 @@ bool LossyRouter::_SWAllocAddReq(int input, int vc, int output)
 
 void LossyRouter::_SWAllocEvaluate( )
 {
+  PROFILE_PHASE( ROUTER_SW_ALLOC );
   bool watched = false;
 
   for(deque<pair<int, pair<pair<int, int>, int> > >::iterator iter = _sw_alloc_vcs.begin();
@@ -1483,11 +1516,11 @@ void LossyRouter::_SWAllocEvaluate( )
     OutputSet const * const route_set = cur_buf->GetRouteSet(vc);
     assert(route_set);
 
-    set<OutputSet::sSetElement> const setlist = route_set->GetSet();
+    OutputSet::ElementList const & setlist = route_set->GetSet();
 
     assert(!_noq || (setlist.size() == 1));
 
-    for(set<OutputSet::sSetElement>::const_iterator iset = setlist.begin();
+    for(OutputSet::ElementList::const_iterator iset = setlist.begin();
 	iset != setlist.end();
 	++iset) {
 
@@ -1827,7 +1860,7 @@ void LossyRouter::_SWAllocEvaluate( )
 	  OutputSet const * const route_set = cur_buf->GetRouteSet(vc);
 	  assert(route_set);
 
-	  set<OutputSet::sSetElement> const setlist = route_set->GetSet();
+	  OutputSet::ElementList const & setlist = route_set->GetSet();
 
 	  bool busy = true;
 	  bool full = true;
@@ -1835,7 +1868,7 @@ void LossyRouter::_SWAllocEvaluate( )
 
 	  assert(!_noq || (setlist.size() == 1));
 
-	  for(set<OutputSet::sSetElement>::const_iterator iset = setlist.begin();
+	  for(OutputSet::ElementList::const_iterator iset = setlist.begin();
 	      iset != setlist.end();
 	      ++iset) {
 	    if(iset->output_port == output) {
@@ -1921,6 +1954,7 @@ void LossyRouter::_SWAllocEvaluate( )
 
 void LossyRouter::_SWAllocUpdate( )
 {
+  PROFILE_PHASE( ROUTER_SW_ALLOC );
   while(!_sw_alloc_vcs.empty()) {
 
     pair<int, pair<pair<int, int>, int> > const & item = _sw_alloc_vcs.front();
@@ -1982,11 +2016,11 @@ void LossyRouter::_SWAllocUpdate( )
 	int match_prio = numeric_limits<int>::min();
 
 	const OutputSet * route_set = cur_buf->GetRouteSet(vc);
-	set<OutputSet::sSetElement> const setlist = route_set->GetSet();
+	OutputSet::ElementList const & setlist = route_set->GetSet();
 
 	assert(!_noq || (setlist.size() == 1));
 
-	for(set<OutputSet::sSetElement>::const_iterator iset = setlist.begin();
+	for(OutputSet::ElementList::const_iterator iset = setlist.begin();
 	    iset != setlist.end();
 	    ++iset) {
 	  if(iset->output_port == output) {
@@ -2232,6 +2266,7 @@ void LossyRouter::_SWAllocUpdate( )
 
 void LossyRouter::_SwitchEvaluate( )
 {
+  PROFILE_PHASE( ROUTER_SWITCH );
   for(deque<pair<int, pair<Flit *, pair<int, int> > > >::iterator iter = _crossbar_flits.begin();
       iter != _crossbar_flits.end();
       ++iter) {
@@ -2265,6 +2300,7 @@ void LossyRouter::_SwitchEvaluate( )
 
 void LossyRouter::_SwitchUpdate( )
 {
+  PROFILE_PHASE( ROUTER_SWITCH );
   while(!_crossbar_flits.empty()) {
 
     pair<int, pair<Flit *, pair<int, int> > > const & item = _crossbar_flits.front();
@@ -2303,7 +2339,7 @@ void LossyRouter::_SwitchUpdate( )
 		 << " at output " << output
 		 << "." << endl;
     }
-    _output_buffer[output].push(f);
+    _output_buffer[output].push(f->GetHandle());
     //the output buffer size isn't precise due to flits in flight
     //but there is a maximum bound based on output speed up and ST traversal
     assert(_output_buffer[output].size()<=(size_t)_output_buffer_size+ _crossbar_delay* _output_speedup+( _output_speedup-1) ||_output_buffer_size==-1);
@@ -2319,6 +2355,7 @@ void LossyRouter::_SwitchUpdate( )
 
 void LossyRouter::_OutputQueuing( )
 {
+  PROFILE_PHASE( ROUTER_OUTPUT );
   for(map<int, Credit *>::const_iterator iter = _out_queue_credits.begin();
       iter != _out_queue_credits.end();
       ++iter) {
@@ -2341,9 +2378,10 @@ void LossyRouter::_OutputQueuing( )
 
 void LossyRouter::_SendFlits( )
 {
+  PROFILE_PHASE( ROUTER_OUTPUT );
   for ( int output = 0; output < _outputs; ++output ) {
     if ( !_output_buffer[output].empty( ) ) {
-      Flit * const f = _output_buffer[output].front( );
+      Flit * const f = Flit::FromHandle(_output_buffer[output].front( ));
       assert(f);
       _output_buffer[output].pop( );
 
@@ -2366,6 +2404,7 @@ void LossyRouter::_SendFlits( )
 
 void LossyRouter::_SendCredits( )
 {
+  PROFILE_PHASE( ROUTER_OUTPUT );
   for ( int input = 0; input < _inputs; ++input ) {
     if ( !_credit_buffer[input].empty( ) ) {
       Credit * const c = _credit_buffer[input].front( );
@@ -2453,7 +2492,7 @@ void LossyRouter::_UpdateNOQ(int input, int vc, Flit const * f) {
   assert(f);
   assert(f->vc == vc);
   assert(f->head);
-  set<OutputSet::sSetElement> sl = f->la_route_set.GetSet();
+  OutputSet::ElementList sl = f->la_route_set.GetSet();
   assert(sl.size() == 1);
   int out_port = sl.begin()->output_port;
   const FlitChannel * channel = _output_channels[out_port];
@@ -95,7 +95,7 @@ class LossyRouter : public Router {
   tRoutingFunction   _rf;
 
   int _output_buffer_size;
-  vector<queue<Flit *> > _output_buffer;
+  vector<queue<Flit::Handle> > _output_buffer;
 
   vector<queue<Credit *> > _credit_buffer;
 
@@ -106,6 +106,7 @@ class LossyRouter : public Router {
 
   vector<bool> _drop_packet_at_input;
   float _random_packet_drop_rate;
+  int64_t _dropped_flits;
 
   bool _noq;
   vector<vector<int> > _noq_next_output_port;
@@ -166,10 +167,13 @@ public:
   virtual void ReadInputs( );
   virtual void WriteOutputs( );
 
+  virtual bool IsIdle( ) const;
+
   void Display( ostream & os = cout ) const;
 
   virtual int GetUsedCredit(int o) const;
   virtual int GetBufferOccupancy(int i) const;
+  virtual int64_t GetDroppedFlits() const { return _dropped_flits; }
 
 #ifdef TRACK_BUFFERS
   virtual int GetUsedCreditForClass(int output, int cl) const;
@@ -41,6 +41,7 @@
 #include "booksim.hpp"
 #include <iostream>
 #include <cassert>
+#include <cmath>
 #include "router.hpp"
 
 //////////////////Sub router types//////////////////////
@@ -71,6 +72,8 @@ TimedModule( parent, name ), _id( id ), _inputs( inputs ), _outputs( outputs ),
   _internal_speedup = config.GetFloat( "internal_speedup" );
   _classes          = config.GetInt( "classes" );
 
+  _random.SetId( FullName( ) );
+
 #ifdef TRACK_FLOWS
   _received_flits.resize(_classes, vector<int>(_inputs, 0));
   _stored_flits.resize(_classes);
@@ -106,6 +109,7 @@ void Router::AddOutputChannel( FlitChannel *channel, CreditChannel *backchannel
 
 void Router::Evaluate( )
 {
+  RandomStreamScope random_scope( &_random );
   _partial_internal_cycles += _internal_speedup;
   while( _partial_internal_cycles >= 1.0 ) {
     _InternalStep( );
@@ -113,6 +117,52 @@ void Router::Evaluate( )
   }
 }
 
+void Router::SkipIdleCycles( int64_t cycles )
+{
+  // Replay the speedup accumulation so that internal steps stay aligned with
+  // the serial schedule; idle routers do nothing in _InternalStep.
+  if ( ( _partial_internal_cycles == 0.0 ) &&
+       ( _internal_speedup == floor( _internal_speedup ) ) ) {
+    return;
+  }
+  for ( int64_t c = 0; c < cycles; ++c ) {
+    _partial_internal_cycles += _internal_speedup;
+    while( _partial_internal_cycles >= 1.0 ) {
+      _partial_internal_cycles -= 1.0;
+    }
+  }
+}
+
+void Router::Checkpoint( CheckpointFile & cp )
+{
+  cp.Check( FullName( ) + " inputs", _inputs );
+  cp.Check( FullName( ) + " outputs", _outputs );
+  cp.Io( _partial_internal_cycles );
+  if ( gRandomStreams ) {
+    cp.Io( _random.Counter( ) );
+  }
+#ifdef TRACK_FLOWS
+  cp.Io( _received_flits );
+  cp.Io( _stored_flits );
+  cp.Io( _sent_flits );
+  cp.Io( _outstanding_credits );
+  cp.Io( _active_packets );
+#endif
+#ifdef TRACK_STALLS
+  cp.Io( _buffer_busy_stalls );
+  cp.Io( _buffer_conflict_stalls );
+  cp.Io( _buffer_full_stalls );
+  cp.Io( _buffer_reserved_stalls );
+  cp.Io( _crossbar_conflict_stalls );
+#endif
+  _Checkpoint( cp );
+}
+
+void Router::_Checkpoint( CheckpointFile & cp )
+{
+  Error( "Checkpointing is not supported by this router type." );
+}
+
 void Router::OutChannelFault( int c, bool fault )
 {
   assert( ( c >= 0 ) && ( (size_t)c < _channel_faults.size( ) ) );
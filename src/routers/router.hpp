@@ -37,6 +37,7 @@
 #include "flitchannel.hpp"
 #include "channel.hpp"
 #include "config_utils.hpp"
+#include "random_utils.hpp"
 
 typedef Channel<Credit> CreditChannel;
 
@@ -63,6 +64,9 @@ protected:
   double _internal_speedup;
   double _partial_internal_cycles;
 
+  // draws made while the router is evaluated, with random_streams
+  RandomStream _random;
+
   int _crossbar_delay;
   int _credit_delay;
   
@@ -90,6 +94,10 @@ protected:
 
   virtual void _InternalStep() = 0;
 
+  // Saves or restores the state of the derived router; routers without
+  // checkpoint support reject the request.
+  virtual void _Checkpoint( CheckpointFile & cp );
+
 public:
   Router( const Configuration& config,
 	  Module *parent, const string & name, int id,
@@ -110,11 +118,22 @@ public:
     assert((output >= 0) && (output < _outputs));
     return _output_channels[output];
   }
+  // Channels whose output this router consumes in ReadInputs
+  inline vector<FlitChannel *> const & GetInputChannels( ) const {
+    return _input_channels;
+  }
+  inline vector<CreditChannel *> const & GetOutputCredits( ) const {
+    return _output_credits;
+  }
 
   virtual void ReadInputs( ) = 0;
   virtual void Evaluate( );
+  virtual void SkipIdleCycles( int64_t cycles );
   virtual void WriteOutputs( ) = 0;
 
+  void Checkpoint( CheckpointFile & cp );
+  virtual bool CanCheckpoint( ) const { return false; }
+
   void OutChannelFault( int c, bool fault = true );
   bool IsFaultyOutput( int c ) const;
 
@@ -123,6 +142,8 @@ public:
 
   virtual int GetUsedCredit(int o) const = 0;
   virtual int GetBufferOccupancy(int i) const = 0;
+  // flits discarded by the router since construction
+  virtual int64_t GetDroppedFlits() const { return 0; }
 
 #ifdef TRACK_BUFFERS
   virtual int GetUsedCreditForClass(int output, int cl) const = 0;
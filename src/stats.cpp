@@ -44,11 +44,10 @@
 
 Stats::Stats( Module *parent, const string &name,
 	      double bin_size, int num_bins ) :
-  Module( parent, name ), _num_bins( num_bins ), _bin_size( bin_size )
+  Module( parent, name ), _num_bins( num_bins ), _bin_size( bin_size ),
+  _quantiles( bin_size )
 {
   Clear();
-  g = new stmpct::gk<double>(0.1);
-  _need_percentile = false;
 }
 
 void Stats::Clear( )
@@ -62,12 +61,22 @@ void Stats::Clear( )
   _min = numeric_limits<double>::quiet_NaN();
   _max = -numeric_limits<double>::quiet_NaN();
 
-  if (g)
-    delete g;
-  g = new stmpct::gk<double>(0.1);
+  _quantiles.Clear();
   //  _reset = true;
 }
 
+void Stats::Checkpoint( CheckpointFile & cp )
+{
+  cp.Check( FullName( ) + " bins", _num_bins );
+  cp.Io( _num_samples );
+  cp.Io( _sample_sum );
+  cp.Io( _sample_squared_sum );
+  cp.Io( _min );
+  cp.Io( _max );
+  cp.Io( _hist );
+  _quantiles.Checkpoint( cp );
+}
+
 double Stats::Average( ) const
 {
   if (!_num_samples) return 0.0;
@@ -106,15 +115,31 @@ int Stats::NumSamples( ) const
 
 double Stats::Percentile(double percentile) const{
     if (!_num_samples) return 0.0;
-    assert(_need_percentile);
-    return g->quantile(percentile);
+    // a bucket's midpoint can lie outside the range actually seen
+    return fmin(fmax(_quantiles.Quantile(percentile), _min), _max);
 }
 
-void Stats::AddSample( double val )
+void Stats::Merge( const Stats & other )
 {
-  if (_need_percentile){
-    g->insert(val);
+  assert((_bin_size == other._bin_size) && (_num_bins == other._num_bins));
+  if (!other._num_samples) return;
+
+  _num_samples += other._num_samples;
+  _sample_sum += other._sample_sum;
+  _sample_squared_sum += other._sample_squared_sum;
+
+  _max = !(other._max <= _max) ? other._max : _max;
+  _min = !(other._min >= _min) ? other._min : _min;
+
+  for(int b = 0; b < _num_bins; ++b) {
+    _hist[b] += other._hist[b];
   }
+  _quantiles.Merge(other._quantiles);
+}
+
+void Stats::AddSample( double val )
+{
+  _quantiles.AddSample(val);
 
   ++_num_samples;
   _sample_sum += val;
@@ -147,5 +172,4 @@ ostream & operator<<(ostream & os, const Stats & s) {
 
 
 Stats::~Stats() {
-    if (g != NULL) delete g;
 }
@@ -29,7 +29,8 @@
 #define _STATS_HPP_
 
 #include "module.hpp"
-#include "gk.hpp"
+#include "hdr_histogram.hpp"
+#include "checkpoint.hpp"
 
 class Stats : public Module {
   int    _num_samples;
@@ -45,7 +46,7 @@ class Stats : public Module {
 
 
   vector<int> _hist;
-  stmpct::gk<double> * g;
+  HdrHistogram _quantiles;
 
 public:
   Stats( Module *parent, const string &name,
@@ -62,6 +63,9 @@ public:
   int    NumSamples( ) const;
   double Percentile(double percentile) const;
 
+  // Adds the samples of another Stats with the same bin size.
+  void Merge( const Stats & other );
+
   void AddSample( double val );
   inline void AddSample( int val ) {
     AddSample( (double)val );
@@ -73,8 +77,9 @@ public:
 
   int GetBin(int b){ return _hist[b];}
 
+  void Checkpoint( CheckpointFile & cp );
+
   void Display( ostream & os = cout ) const;
-  bool _need_percentile;
   virtual ~Stats();
 
   friend ostream & operator<<(ostream & os, const Stats & s);
@@ -0,0 +1,200 @@
+/*telemetry.cpp
+ *
+ *Columnar time series of router, channel and endpoint counters
+ *
+ */
+
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+
+#include "booksim.hpp"
+#include "telemetry.hpp"
+#include "network.hpp"
+#include "endpoint.hpp"
+
+static char const TELEMETRY_MAGIC[8] = { 'B', 'S', 'T', 'E', 'L', 'E', 'M', '1' };
+
+// rows buffered per column before a block is written
+static size_t const TELEMETRY_BLOCK_ROWS = 256;
+
+Telemetry::Telemetry( Configuration const & config, vector<Network *> const & net,
+                      vector<EndPoint *> const & endpoints )
+  : _net( net ), _endpoints( endpoints ), _next_sample( 0 ), _started( false )
+{
+  string const filename = config.GetStr( "telemetry_file" );
+  _window = config.GetInt( "telemetry_window" );
+  if ( _window <= 0 ) {
+    cout << "Error: telemetry_window must be positive." << endl;
+    exit( -1 );
+  }
+
+  bool occupancy = false, channels = false, opb = false, drops = false, retransmits = false;
+  vector<string> const counters = config.GetStrArray( "telemetry_counters" );
+  for ( size_t i = 0; i < counters.size( ); ++i ) {
+    if ( counters[i] == "occupancy" ) {
+      occupancy = true;
+    } else if ( counters[i] == "channels" ) {
+      channels = true;
+    } else if ( counters[i] == "opb" ) {
+      opb = true;
+    } else if ( counters[i] == "drops" ) {
+      drops = true;
+    } else if ( counters[i] == "retransmits" ) {
+      retransmits = true;
+    } else {
+      cout << "Error: unknown telemetry counter " << counters[i] << endl;
+      exit( -1 );
+    }
+  }
+
+  for ( size_t s = 0; s < _net.size( ); ++s ) {
+    for ( int r = 0; r < _net[s]->NumRouters( ); ++r ) {
+      ostringstream name;
+      name << "net" << s << ".router" << r;
+      if ( occupancy ) {
+        _AddColumn( name.str( ) + ".occupancy", ROUTER_OCCUPANCY, s, r );
+      }
+      if ( drops ) {
+        _AddColumn( name.str( ) + ".drops", DROPPED_FLITS, s, r );
+      }
+    }
+    if ( channels ) {
+      for ( int c = 0; c < _net[s]->NumChannels( ); ++c ) {
+        ostringstream name;
+        name << "net" << s << ".channel" << c << ".flits";
+        _AddColumn( name.str( ), CHANNEL_FLITS, s, c );
+      }
+    }
+  }
+  for ( size_t n = 0; n < _endpoints.size( ); ++n ) {
+    ostringstream name;
+    name << "node" << n;
+    if ( opb ) {
+      _AddColumn( name.str( ) + ".opb", OPB_OCCUPANCY, -1, n );
+    }
+    if ( retransmits ) {
+      _AddColumn( name.str( ) + ".retransmits", RETRANSMITTED_FLITS, -1, n );
+    }
+  }
+
+  _file = fopen( filename.c_str( ), "wb" );
+  if ( !_file ) {
+    cout << "Error: cannot create telemetry file " << filename << endl;
+    exit( -1 );
+  }
+  int64_t const columns = _names.size( ) + 1;
+  fwrite( TELEMETRY_MAGIC, 1, sizeof( TELEMETRY_MAGIC ), _file );
+  fwrite( &_window, sizeof( _window ), 1, _file );
+  fwrite( &columns, sizeof( columns ), 1, _file );
+  vector<string> names( 1, "cycle" );
+  names.insert( names.end( ), _names.begin( ), _names.end( ) );
+  for ( size_t i = 0; i < names.size( ); ++i ) {
+    int64_t const length = names[i].size( );
+    fwrite( &length, sizeof( length ), 1, _file );
+    fwrite( names[i].data( ), 1, length, _file );
+  }
+
+  _rows.resize( columns );
+  for ( size_t i = 0; i < _rows.size( ); ++i ) {
+    _rows[i].reserve( TELEMETRY_BLOCK_ROWS );
+  }
+}
+
+Telemetry::~Telemetry( )
+{
+  _Flush( );
+  if ( fclose( _file ) != 0 ) {
+    cout << "Error: writing the telemetry file failed." << endl;
+  }
+}
+
+void Telemetry::Restart( )
+{
+  _next_sample = 0;
+  _started = false;
+}
+
+void Telemetry::_AddColumn( string const & name, Source source, int subnet, int index )
+{
+  Column col;
+  col.source = source;
+  col.subnet = subnet;
+  col.index = index;
+  col.last = 0;
+  _names.push_back( name );
+  _columns.push_back( col );
+}
+
+int64_t Telemetry::_Read( Column const & col ) const
+{
+  switch ( col.source ) {
+  case ROUTER_OCCUPANCY:
+    {
+      Router const * const router = _net[col.subnet]->GetRouter( col.index );
+      int64_t occupancy = 0;
+      for ( int i = 0; i < router->NumInputs( ); ++i ) {
+        occupancy += router->GetBufferOccupancy( i );
+      }
+      return occupancy;
+    }
+  case CHANNEL_FLITS:
+    {
+      vector<int> const & active = _net[col.subnet]->GetChannels( )[col.index]->GetActivity( );
+      int64_t flits = 0;
+      for ( size_t c = 0; c < active.size( ); ++c ) {
+        flits += active[c];
+      }
+      return flits;
+    }
+  case OPB_OCCUPANCY:
+    return _endpoints[col.index]->OPBOccupancy( );
+  case DROPPED_FLITS:
+    return _net[col.subnet]->GetRouter( col.index )->GetDroppedFlits( );
+  case RETRANSMITTED_FLITS:
+    return _endpoints[col.index]->FlitsRetransmitted( );
+  }
+  return 0;
+}
+
+void Telemetry::_Record( int64_t time )
+{
+  _next_sample = ( time / _window + 1 ) * _window;
+
+  bool const record = _started;
+  _started = true;
+  if ( record ) {
+    _rows[0].push_back( time );
+  }
+  for ( size_t i = 0; i < _columns.size( ); ++i ) {
+    Column & col = _columns[i];
+    int64_t const value = _Read( col );
+    if ( ( col.source == ROUTER_OCCUPANCY ) || ( col.source == OPB_OCCUPANCY ) ) {
+      if ( record ) {
+        _rows[i + 1].push_back( value );
+      }
+    } else {
+      if ( record ) {
+        _rows[i + 1].push_back( value - col.last );
+      }
+      col.last = value;
+    }
+  }
+
+  if ( _rows[0].size( ) >= TELEMETRY_BLOCK_ROWS ) {
+    _Flush( );
+  }
+}
+
+void Telemetry::_Flush( )
+{
+  int64_t const rows = _rows[0].size( );
+  if ( rows == 0 ) {
+    return;
+  }
+  fwrite( &rows, sizeof( rows ), 1, _file );
+  for ( size_t i = 0; i < _rows.size( ); ++i ) {
+    fwrite( &_rows[i][0], sizeof( int64_t ), rows, _file );
+    _rows[i].clear( );
+  }
+}
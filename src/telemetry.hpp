@@ -0,0 +1,86 @@
+/*telemetry.hpp
+ *
+ *Per-window time series of network counters, written to a columnar binary
+ *file. Every telemetry_window cycles one row is recorded: the current cycle
+ *followed by one value per column. Occupancies are sampled at the end of
+ *the window; flit, drop and retransmission counts are the increase over the
+ *window. Rows are buffered and written in blocks, column by column, so a
+ *reader can load a single counter without touching the others.
+ *
+ *File layout (native byte order):
+ *  "BSTELEM1"                          magic
+ *  int64 window, int64 columns
+ *  columns x { int64 length, name }    column names, "cycle" first
+ *  blocks of { int64 rows, columns x rows int64 values }
+ *
+ *utils/telemetry.py reads these files.
+ *
+ */
+
+#ifndef _TELEMETRY_HPP_
+#define _TELEMETRY_HPP_
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "config_utils.hpp"
+
+using namespace std;
+
+class Network;
+class EndPoint;
+
+class Telemetry {
+
+public:
+  Telemetry( Configuration const & config, vector<Network *> const & net,
+             vector<EndPoint *> const & endpoints );
+  ~Telemetry( );
+
+  // Called whenever simulation time advances; records a row for each
+  // window boundary that has been reached.
+  inline void Sample( int64_t time ) {
+    if ( time >= _next_sample ) {
+      _Record( time );
+    }
+  }
+
+  // Starts a new series, e.g. for the next of several simulations; the
+  // first sample only sets the baseline for the counts.
+  void Restart( );
+
+private:
+  enum Source { ROUTER_OCCUPANCY, CHANNEL_FLITS, OPB_OCCUPANCY, DROPPED_FLITS,
+                RETRANSMITTED_FLITS };
+
+  struct Column {
+    Source source;
+    int subnet;
+    int index;
+    int64_t last;
+  };
+
+  void _AddColumn( string const & name, Source source, int subnet, int index );
+  int64_t _Read( Column const & col ) const;
+  void _Record( int64_t time );
+  void _Flush( );
+
+  vector<Network *> _net;
+  vector<EndPoint *> _endpoints;
+
+  int64_t _window;
+  int64_t _next_sample;
+  bool _started;
+
+  vector<string> _names;
+  vector<Column> _columns;
+
+  // one buffer per column, including the cycle column
+  vector<vector<int64_t> > _rows;
+
+  FILE * _file;
+};
+
+#endif
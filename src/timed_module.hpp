@@ -28,6 +28,8 @@
 #ifndef _TIMED_MODULE_HPP_
 #define _TIMED_MODULE_HPP_
 
+#include <stdint.h>
+
 #include "module.hpp"
 
 class TimedModule : public Module {
@@ -39,6 +41,11 @@ public:
   virtual void ReadInputs() = 0;
   virtual void Evaluate() = 0;
   virtual void WriteOutputs() = 0;
+
+  // Idle-cycle skipping: a module is idle when it holds no pending work and
+  // its state does not change until something arrives at one of its inputs.
+  virtual bool IsIdle() const { return false; }
+  virtual void SkipIdleCycles(int64_t cycles) {}
 };
 
 #endif
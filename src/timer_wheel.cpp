@@ -0,0 +1,255 @@
+/*timer_wheel.cpp
+ *
+ *Hierarchical timing wheel, see timer_wheel.hpp.
+ *
+ */
+
+#include "timer_wheel.hpp"
+
+#include <algorithm>
+#include <limits>
+
+TimerWheel::TimerWheel( )
+  : _now(0), _free(-1)
+{
+  List const empty = { -1, -1 };
+  _lists.assign(LISTS, empty);
+  for ( int l = 0; l < LEVELS; ++l ) {
+    _occupied[l] = 0;
+  }
+}
+
+void TimerWheel::Schedule( int64_t time, int dest, int seq_num )
+{
+  int64_t const key = _Key(dest, seq_num);
+  unordered_map<int64_t, int>::iterator iter = _index.find(key);
+  int n;
+  if ( iter != _index.end( ) ) {
+    n = iter->second;
+    _Unlink(n);
+  } else {
+    if ( _free >= 0 ) {
+      n = _free;
+      _free = _nodes[n].next;
+    } else {
+      n = _nodes.size( );
+      _nodes.push_back(Node());
+    }
+    _index[key] = n;
+  }
+  Timer const timer = { time, dest, seq_num };
+  _nodes[n].timer = timer;
+  _Place(n);
+}
+
+void TimerWheel::Cancel( int dest, int seq_num )
+{
+  unordered_map<int64_t, int>::iterator iter = _index.find(_Key(dest, seq_num));
+  if ( iter != _index.end( ) ) {
+    int const n = iter->second;
+    _index.erase(iter);
+    _Unlink(n);
+    _Release(n);
+  }
+}
+
+bool TimerWheel::PopExpired( int64_t now, Timer & timer )
+{
+  _Advance(now);
+  int const n = _lists[DUE_LIST].head;
+  if ( n < 0 ) {
+    return false;
+  }
+  timer = _nodes[n].timer;
+  _index.erase(_Key(timer.dest, timer.seq_num));
+  _Unlink(n);
+  _Release(n);
+  return true;
+}
+
+int64_t TimerWheel::NextExpiry( ) const
+{
+  int list = -1;
+  if ( _lists[DUE_LIST].head >= 0 ) {
+    list = DUE_LIST;
+  } else {
+    // Slots behind the current one are always empty, so the lowest
+    // occupied slot of the lowest occupied level holds the earliest timers.
+    for ( int l = 0; ( l < LEVELS ) && ( list < 0 ); ++l ) {
+      if ( _occupied[l] ) {
+        list = l * SLOTS + __builtin_ctzll(_occupied[l]);
+      }
+    }
+    if ( list < 0 ) {
+      list = FAR_LIST;
+    }
+  }
+  int64_t next = numeric_limits<int64_t>::max();
+  for ( int n = _lists[list].head; n >= 0; n = _nodes[n].next ) {
+    next = min(next, _nodes[n].timer.time);
+  }
+  return next;
+}
+
+void TimerWheel::Checkpoint( CheckpointFile & cp )
+{
+  vector<Timer> timers;
+  if ( cp.IsSaving( ) ) {
+    _Collect(timers);
+  }
+  cp.Io(_now);
+  cp.Io(timers);
+  if ( !cp.IsSaving( ) ) {
+    int64_t const now = _now;
+    *this = TimerWheel();
+    _now = now;
+    for ( size_t i = 0; i < timers.size( ); ++i ) {
+      Schedule(timers[i].time, timers[i].dest, timers[i].seq_num);
+    }
+  }
+}
+
+void TimerWheel::_Place( int n )
+{
+  int64_t const time = _nodes[n].timer.time;
+  int list;
+  if ( time <= _now ) {
+    list = DUE_LIST;
+  } else {
+    // the highest group of bits in which the expiry differs from now
+    int const level = ( 63 - __builtin_clzll(time ^ _now) ) / LEVEL_BITS;
+    if ( level >= LEVELS ) {
+      list = FAR_LIST;
+    } else {
+      list = level * SLOTS + ( ( time >> ( level * LEVEL_BITS ) ) & ( SLOTS - 1 ) );
+    }
+  }
+  _Link(n, list);
+}
+
+void TimerWheel::_Link( int n, int list )
+{
+  Node & node = _nodes[n];
+  List & l = _lists[list];
+  node.list = list;
+  node.prev = l.tail;
+  node.next = -1;
+  if ( l.tail >= 0 ) {
+    _nodes[l.tail].next = n;
+  } else {
+    l.head = n;
+  }
+  l.tail = n;
+  if ( list < DUE_LIST ) {
+    _occupied[list / SLOTS] |= 1ULL << ( list % SLOTS );
+  }
+}
+
+void TimerWheel::_Unlink( int n )
+{
+  Node & node = _nodes[n];
+  List & l = _lists[node.list];
+  if ( node.prev >= 0 ) {
+    _nodes[node.prev].next = node.next;
+  } else {
+    l.head = node.next;
+  }
+  if ( node.next >= 0 ) {
+    _nodes[node.next].prev = node.prev;
+  } else {
+    l.tail = node.prev;
+  }
+  if ( ( node.list < DUE_LIST ) && ( l.head < 0 ) ) {
+    _occupied[node.list / SLOTS] &= ~( 1ULL << ( node.list % SLOTS ) );
+  }
+}
+
+void TimerWheel::_Release( int n )
+{
+  _nodes[n].next = _free;
+  _free = n;
+}
+
+// Re-places every timer of a list relative to the current time, which moves
+// it to a lower level or to the due list.
+void TimerWheel::_Cascade( int list )
+{
+  int n = _lists[list].head;
+  List const empty = { -1, -1 };
+  _lists[list] = empty;
+  if ( list < DUE_LIST ) {
+    _occupied[list / SLOTS] &= ~( 1ULL << ( list % SLOTS ) );
+  }
+  while ( n >= 0 ) {
+    int const next = _nodes[n].next;
+    _Place(n);
+    n = next;
+  }
+}
+
+void TimerWheel::_Advance( int64_t now )
+{
+  if ( now < _now ) {
+    _Rebase(now);
+    return;
+  }
+  if ( now == _now ) {
+    return;
+  }
+  int64_t const old = _now;
+  _now = now;
+
+  // Bottom-up, so that cascaded timers land in slots that are not visited
+  // again. Within a level, the slots from just past the old time up to the
+  // new one are due or belong lower; if the time left the level's span
+  // altogether, all of them are.
+  for ( int l = 0; l < LEVELS; ++l ) {
+    int const shift = l * LEVEL_BITS;
+    uint64_t mask;
+    if ( ( old >> ( shift + LEVEL_BITS ) ) != ( now >> ( shift + LEVEL_BITS ) ) ) {
+      mask = ~0ULL;
+    } else {
+      int const from = ( old >> shift ) & ( SLOTS - 1 );
+      int const to = ( now >> shift ) & ( SLOTS - 1 );
+      if ( from == to ) {
+        continue;
+      }
+      mask = ( ( to == SLOTS - 1 ) ? ~0ULL : ( ( 1ULL << ( to + 1 ) ) - 1 ) ) &
+             ~( ( 1ULL << ( from + 1 ) ) - 1 );
+    }
+    uint64_t pending = _occupied[l] & mask;
+    while ( pending ) {
+      int const slot = __builtin_ctzll(pending);
+      pending &= pending - 1;
+      _Cascade(l * SLOTS + slot);
+    }
+  }
+  if ( ( old >> ( LEVELS * LEVEL_BITS ) ) != ( now >> ( LEVELS * LEVEL_BITS ) ) ) {
+    _Cascade(FAR_LIST);
+  }
+}
+
+// The simulation time went back (a new simulation run): re-place everything.
+void TimerWheel::_Rebase( int64_t now )
+{
+  vector<Timer> timers;
+  _Collect(timers);
+  *this = TimerWheel();
+  _now = now;
+  for ( size_t i = 0; i < timers.size( ); ++i ) {
+    Schedule(timers[i].time, timers[i].dest, timers[i].seq_num);
+  }
+}
+
+// Pending timers, due ones first, then by slot.
+void TimerWheel::_Collect( vector<Timer> & timers ) const
+{
+  timers.clear();
+  timers.reserve(_index.size( ));
+  for ( int i = 0; i < LISTS; ++i ) {
+    int const list = ( i == 0 ) ? DUE_LIST : ( i < LISTS - 1 ) ? ( i - 1 ) : FAR_LIST;
+    for ( int n = _lists[list].head; n >= 0; n = _nodes[n].next ) {
+      timers.push_back(_nodes[n].timer);
+    }
+  }
+}
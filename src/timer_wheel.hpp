@@ -0,0 +1,92 @@
+/*timer_wheel.hpp
+ *
+ *Hierarchical timing wheel for the endpoint retry and response timers.
+ *Timers are keyed by (dest, seq_num); scheduling a key that is already
+ *pending moves it, and Cancel() drops it, both in O(1). Level l has 64
+ *slots of 64^l cycles each, relative to the last time the wheel was
+ *advanced to; timers further out than the top level wait in an overflow
+ *list. Advancing cascades the slots that became current one level down, so
+ *every timer moves at most once per level.
+ *
+ */
+
+#ifndef _TIMER_WHEEL_HPP_
+#define _TIMER_WHEEL_HPP_
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+#include "checkpoint.hpp"
+
+using namespace std;
+
+class TimerWheel {
+
+public:
+  struct Timer {
+    int64_t time;
+    int dest;
+    int seq_num;
+  };
+
+  TimerWheel( );
+
+  // Arms the timer for (dest, seq_num) to expire at time, replacing the
+  // pending one for the same key.
+  void Schedule( int64_t time, int dest, int seq_num );
+  void Cancel( int dest, int seq_num );
+
+  // Removes one timer that expires at or before now and returns true, or
+  // returns false if there is none. now must not decrease between calls.
+  bool PopExpired( int64_t now, Timer & timer );
+
+  // Expiry time of the earliest pending timer, INT64_MAX if there is none.
+  int64_t NextExpiry( ) const;
+
+  inline bool empty( ) const { return _index.empty( ); }
+  inline size_t size( ) const { return _index.size( ); }
+
+  void Checkpoint( CheckpointFile & cp );
+
+private:
+  static int const LEVEL_BITS = 6;
+  static int const SLOTS = 1 << LEVEL_BITS;
+  static int const LEVELS = 4;
+  static int const DUE_LIST = LEVELS * SLOTS;  // expired, in expiry order
+  static int const FAR_LIST = DUE_LIST + 1;    // beyond the top level
+  static int const LISTS = FAR_LIST + 1;
+
+  struct Node {
+    Timer timer;
+    int list;
+    int prev;
+    int next;
+  };
+  struct List {
+    int head;
+    int tail;
+  };
+
+  int64_t _now;
+  vector<Node> _nodes;
+  int _free;
+  vector<List> _lists;
+  uint64_t _occupied[LEVELS];  // non-empty slots per level
+  unordered_map<int64_t, int> _index;
+
+  static inline int64_t _Key( int dest, int seq_num ) {
+    return ( (int64_t)dest << 32 ) | (uint32_t)seq_num;
+  }
+
+  void _Place( int n );
+  void _Link( int n, int list );
+  void _Unlink( int n );
+  void _Release( int n );
+  void _Cascade( int list );
+  void _Advance( int64_t now );
+  void _Rebase( int64_t now );
+  void _Collect( vector<Timer> & timers ) const;
+};
+
+#endif
@@ -40,6 +40,7 @@
 #include "vc.hpp"
 #include "packet_reply_info.hpp"
 #include "endpoint.hpp"
+#include "profiler.hpp"
 
 TrafficManager * TrafficManager::New(Configuration const & config,
                                      vector<Network *> const & net)
@@ -75,6 +76,16 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
     _vcs = config.GetInt("num_vcs");
     _subnets = config.GetInt("subnets");
 
+    // Each subnet is a separate Network with its own routers and channels, so
+    // they can be stepped concurrently; endpoints stay on this thread.
+    _subnet_engine = NULL;
+    if ( ( _subnets > 1 ) && ( config.GetInt("parallel_subnets") > 0 ) ) {
+        Flit::SetThreadSafe(true);
+        Credit::SetThreadSafe(true);
+        RandomSetThreadSafe(true);
+        _subnet_engine = new ParallelEngine(_subnets);
+    }
+
     _subnet.resize(Flit::NUM_FLIT_TYPES);
     _subnet[Flit::READ_REQUEST] = config.GetInt("read_request_subnet");
     _subnet[Flit::READ_REPLY] = config.GetInt("read_reply_subnet");
@@ -377,6 +388,15 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
       seed = config.GetInt("seed");
     }
     RandomSeed(seed);
+    gRandomStreams = (config.GetInt("random_streams") > 0);
+    // Routers evaluated on worker threads, by either engine, would otherwise
+    // draw from the shared generator in a schedule-dependent order.
+    if ( ( config.GetInt("sim_threads") > 1 ) && !gRandomStreams ) {
+        Error( "sim_threads > 1 requires random_streams = 1." );
+    }
+    if ( _subnet_engine && !gRandomStreams ) {
+        Error( "parallel_subnets requires random_streams = 1." );
+    }
 
     _measure_latency = (config.GetStr("sim_type") == "latency");
 
@@ -427,6 +447,27 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
     _print_csv_results = config.GetInt( "print_csv_results" );
     _deadlock_warn_timeout = config.GetInt( "deadlock_warn_timeout" );
 
+    _idle_skip = ( config.GetInt( "idle_skip" ) > 0 );
+
+    _checkpoint_save = config.GetStr( "checkpoint_save" );
+    _checkpoint_period = config.GetInt( "checkpoint_period" );
+    _checkpoint_restore = config.GetStr( "checkpoint_restore" );
+    _checkpoint_exit = ( config.GetInt( "checkpoint_exit" ) > 0 );
+    if ( ( ( _checkpoint_save != "" ) || ( _checkpoint_restore != "" ) ) && gSwm ) {
+        Error( "Checkpoints are not supported with SWM workloads." );
+    }
+    if ( ( _checkpoint_save != "" ) && ( _checkpoint_period < 1 ) ) {
+        Error( "checkpoint_period must be at least 1." );
+    }
+    if ( ( _checkpoint_save != "" ) && ( _checkpoint_period > _max_samples ) ) {
+        Error( "checkpoint_period must not exceed max_samples." );
+    }
+
+    _telemetry = NULL;
+    if ( config.GetStr( "telemetry_file" ) != "" ) {
+        _telemetry = new Telemetry( config, _net, _endpoints );
+    }
+
     string watch_file = config.GetStr( "watch_file" );
     if((watch_file != "") && (watch_file != "-")) {
         _LoadWatchList(watch_file);
@@ -526,11 +567,13 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
     _overall_min_plat.resize(_classes, 0.0);
     _overall_avg_plat.resize(_classes, 0.0);
     _overall_max_plat.resize(_classes, 0.0);
+    _overall_plat_stats.resize(_classes);
 
     _nlat_stats.resize(_classes);
     _overall_min_nlat.resize(_classes, 0.0);
     _overall_avg_nlat.resize(_classes, 0.0);
     _overall_max_nlat.resize(_classes, 0.0);
+    _overall_nlat_stats.resize(_classes);
 
     _first_nlat_stats.resize(_classes);
     _overall_min_first_nlat.resize(_classes, 0.0);
@@ -593,11 +636,13 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
         tmp_name << "plat_stat_" << c;
         _plat_stats[c] = new Stats( this, tmp_name.str( ), 1.0, 1000 );
         _stats[tmp_name.str()] = _plat_stats[c];
+        _overall_plat_stats[c] = new Stats( this, "overall_" + tmp_name.str( ), 1.0, 1000 );
         tmp_name.str("");
 
         tmp_name << "nlat_stat_" << c;
         _nlat_stats[c] = new Stats( this, tmp_name.str( ), 1.0, 1000 );
         _stats[tmp_name.str()] = _nlat_stats[c];
+        _overall_nlat_stats[c] = new Stats( this, "overall_" + tmp_name.str( ), 1.0, 1000 );
         tmp_name.str("");
 
         tmp_name << "first_nlat_stat_" << c;
@@ -672,7 +717,9 @@ TrafficManager::~TrafficManager( )
 {
     for ( int c = 0; c < _classes; ++c ) {
         delete _plat_stats[c];
+        delete _overall_plat_stats[c];
         delete _nlat_stats[c];
+        delete _overall_nlat_stats[c];
         delete _first_nlat_stats[c];
         delete _flat_stats[c];
         delete _frag_stats[c];
@@ -710,6 +757,9 @@ TrafficManager::~TrafficManager( )
     if(_max_credits_out) delete _max_credits_out;
 #endif
 
+    delete _subnet_engine;
+    delete _telemetry;
+
     PacketReplyInfo::FreeAll();
     Flit::FreeAll();
     Credit::FreeAll();
@@ -885,6 +935,9 @@ void TrafficManager::_Step( )
 */
 
                 _endpoints[n]->_ReceiveFlit(subnet, f);
+                if ( Profiler::Enabled( ) ) {
+                    Profiler::AddFlits( 1 );
+                }
 
                 // It seems strange that we also count warmup, then in the final stats output,
                 // we only include the running state, not the warming_up state.  That is
@@ -901,7 +954,7 @@ void TrafficManager::_Step( )
             Credit * const c = _net[subnet]->ReadCredit( n );
             if ( c ) {
 #ifdef TRACK_FLOWS
-                for(set<int>::const_iterator iter = c->vc.begin(); iter != c->vc.end(); ++iter) {
+                for(Credit::VCSet::const_iterator iter = c->vc.begin(); iter != c->vc.end(); ++iter) {
                     int const vc = *iter;
                     assert(!_outstanding_classes[n][subnet][vc].empty());
                     int cl = _outstanding_classes[n][subnet][vc].front();
@@ -918,7 +971,14 @@ void TrafficManager::_Step( )
 
             }
         }
-        _net[subnet]->ReadInputs( );
+        if ( !_subnet_engine ) {
+            _net[subnet]->ReadInputs( );
+        }
+    }
+    if ( _subnet_engine ) {
+        _subnet_engine->Run( [this]( int subnet ) {
+                _net[subnet]->ReadInputs( );
+            } );
     }
 
 
@@ -991,18 +1051,94 @@ void TrafficManager::_Step( )
 
         }
 //        flits[subnet].clear();
-        _net[subnet]->Evaluate( );
-        _net[subnet]->WriteOutputs( );
+        if ( !_subnet_engine ) {
+            _net[subnet]->Evaluate( );
+            _net[subnet]->WriteOutputs( );
+        }
+    }
+    if ( _subnet_engine ) {
+        _subnet_engine->Run( [this]( int subnet ) {
+                _net[subnet]->Evaluate( );
+                _net[subnet]->WriteOutputs( );
+            } );
     }
 
     ++_time;
     assert(_time);
+    if ( Profiler::Enabled( ) ) {
+        Profiler::AddCycles( 1 );
+    }
+    if ( _telemetry ) {
+        _telemetry->Sample( _time );
+    }
     if(gTrace){
         cout<<"TIME "<<_time<<endl;
     }
 
 }
 
+int64_t TrafficManager::_NextEventTime( )
+{
+    for ( int c = 0; c < _classes; ++c ) {
+        if ( !_total_in_flight_flits[c].empty() ) {
+            return _time;
+        }
+    }
+
+    // Cheap per-endpoint checks first, so that busy cycles bail out early.
+    int64_t next = numeric_limits<int64_t>::max();
+    for ( int n = 0; n < _nodes; ++n ) {
+        next = min( next, _endpoints[n]->_NextEventTime( ) );
+        if ( next <= _time + 1 ) {
+            return _time;
+        }
+    }
+    for ( int subnet = 0; subnet < _subnets; ++subnet ) {
+        if ( !_net[subnet]->IsIdle( ) ) {
+            return _time;
+        }
+    }
+    for ( int n = 0; n < _nodes; ++n ) {
+        next = min( next, _endpoints[n]->_NextPerDestEventTime( ) );
+        if ( next <= _time + 1 ) {
+            return next;
+        }
+    }
+    return next;
+}
+
+void TrafficManager::_SkipIdleCycles( int64_t cycles )
+{
+    for ( int n = 0; n < _nodes; ++n ) {
+        _endpoints[n]->_SkipIdleCycles( cycles );
+    }
+    for ( int subnet = 0; subnet < _subnets; ++subnet ) {
+        _net[subnet]->SkipIdleCycles( cycles );
+    }
+    _time += cycles;
+    if ( Profiler::Enabled( ) ) {
+        Profiler::AddCycles( cycles );
+    }
+    if ( _telemetry ) {
+        _telemetry->Sample( _time );
+    }
+}
+
+int64_t TrafficManager::_Advance( int64_t max_cycles )
+{
+    if ( _idle_skip && !gTrace ) {
+        int64_t const next = _NextEventTime( );
+        // An idle system with no future event is left to step (and hang) as before.
+        if ( ( next > _time ) && ( next != numeric_limits<int64_t>::max() ) ) {
+            int64_t const cycles = min( next - _time, max_cycles );
+            _SkipIdleCycles( cycles );
+            return cycles;
+        }
+    }
+    _Step( );
+    return 1;
+}
+
 bool TrafficManager::_InjectionsOutstanding( ) const
 {
     for ( int c = 0; c < _classes; ++c ) {
@@ -1160,6 +1296,103 @@ void TrafficManager::_DisplayRemaining( ostream & os ) const
     }
 }
 
+void TrafficManager::_Checkpoint( CheckpointFile & cp )
+{
+    cp.Check( "nodes", _nodes );
+    cp.Check( "routers", _routers );
+    cp.Check( "subnets", _subnets );
+    cp.Check( "classes", _classes );
+    // routers and endpoints save their stream counters only with random_streams
+    cp.Check( "random_streams", gRandomStreams );
+
+    // Flits first, so that every later reference can be resolved by handle.
+    Flit::Checkpoint( cp );
+    Credit::Checkpoint( cp );
+    CheckpointRandomState( cp );
+
+    for ( int s = 0; s < _subnets; ++s ) {
+        _net[s]->Checkpoint( cp );
+    }
+    for ( int n = 0; n < _nodes; ++n ) {
+        _endpoints[n]->Checkpoint( cp );
+    }
+    for ( int c = 0; c < _classes; ++c ) {
+        _injection_process[c]->Checkpoint( cp );
+    }
+
+    cp.Io( _time );
+    cp.Io( _cur_id );
+    cp.Io( _cur_pid );
+    cp.Io( _sim_state );
+    cp.Io( _reset_time );
+    cp.Io( _drain_time );
+    cp.Io( _generation_stopped_time );
+    cp.Io( _empty_network );
+    cp.Io( _deadlock_timer );
+
+    cp.Io( _last_class );
+    cp.Io( _last_vc );
+    cp.Io( _qtime );
+    cp.Io( _qdrained );
+    cp.Io( _partial_packets );
+    cp.Io( _total_in_flight_flits );
+    cp.Io( _measured_in_flight_flits );
+    cp.Io( _retired_packets );
+
+    cp.Io( _packet_seq_no );
+    cp.Io( _requestsOutstanding );
+    for ( int n = 0; n < _nodes; ++n ) {
+        list<PacketReplyInfo *> & pending = _repliesPending[n];
+        uint64_t count = pending.size( );
+        cp.Io( count );
+        if ( !cp.IsSaving( ) ) {
+            while ( !pending.empty( ) ) {
+                pending.front( )->Free( );
+                pending.pop_front( );
+            }
+            for ( uint64_t i = 0; i < count; ++i ) {
+                pending.push_back( PacketReplyInfo::New( ) );
+            }
+        }
+        for ( list<PacketReplyInfo *>::iterator iter = pending.begin( );
+              iter != pending.end( ); ++iter ) {
+            PacketReplyInfo * rinfo = *iter;
+            if ( rinfo->data ) {
+                cp.Error( "pending reply carries a workload message" );
+            }
+            cp.Io( rinfo->source );
+            cp.Io( rinfo->time );
+            cp.Io( rinfo->req_seq_num );
+            cp.Io( rinfo->record );
+            cp.Io( rinfo->type );
+        }
+    }
+
+    cp.Io( _sent_packets );
+    cp.Io( _accepted_packets );
+    cp.Io( _sent_flits );
+    cp.Io( _accepted_flits );
+    cp.Io( _slowest_packet );
+    cp.Io( _slowest_first_inj_to_ret_packet );
+    cp.Io( _slowest_flit );
+    cp.Io( _flits_dropped_for_rget_conversion );
+    cp.Io( _flit_retransmissions );
+    cp.Io( _packet_retransmissions );
+    cp.Io( _standalone_acks_transmitted );
+
+    for ( map<string, Stats *>::iterator iter = _stats.begin( );
+          iter != _stats.end( ); ++iter ) {
+        iter->second->Checkpoint( cp );
+    }
+
+#ifdef TRACK_FLOWS
+    cp.Io( _outstanding_credits );
+    cp.Io( _outstanding_classes );
+    cp.Io( _injected_flits );
+    cp.Io( _ejected_flits );
+#endif
+}
+
 bool TrafficManager::_SingleSim( )
 {
     int converged = 0;
@@ -1178,6 +1411,21 @@ bool TrafficManager::_SingleSim( )
     if(_warmup_periods == 0)
        _sim_state = running;
 
+    if ( _checkpoint_restore != "" ) {
+        CheckpointFile cp( _checkpoint_restore, false );
+        _Checkpoint( cp );
+        cp.Io( prev_latency );
+        cp.Io( prev_accepted );
+        cp.Io( total_accepted_count );
+        cp.Io( prev_accepted_count );
+        cp.Io( total_phases );
+        cp.Io( num_no_accepted_flit_period );
+        cp.Io( converged );
+        cp.Io( clear_last );
+        cout << "Restored checkpoint " << _checkpoint_restore << " at time " << _time << endl;
+        _checkpoint_restore = "";
+    }
+
     while( ( total_phases < _max_samples ) &&
            ( ( _sim_state != running ) ||
              ( ( converged < 3 ) ||
@@ -1195,17 +1443,17 @@ bool TrafficManager::_SingleSim( )
         if (gSwm) {
             if(gSwmAppRunMode) {
                 while(gSimEnabled) {
-                   _Step( );
+                   _Advance( numeric_limits<int64_t>::max() );
                 }
             } else {
-                for (int iter = 0; gSimEnabled && iter < _sample_period; ++iter) {
-                   _Step( );
+                for (int64_t iter = 0; gSimEnabled && iter < _sample_period; ) {
+                   iter += _Advance( _sample_period - iter );
                 }
             }
         } else {
             do {
-                for ( int iter = 0; iter < _sample_period; ++iter )
-                    _Step( );
+                for ( int64_t iter = 0; iter < _sample_period; )
+                    iter += _Advance( _sample_period - iter );
                 total_samples = 0;
                 for(int c = 0; c < _classes; ++c) {
                     total_samples += _plat_stats[c]->NumSamples( );
@@ -1320,6 +1568,7 @@ bool TrafficManager::_SingleSim( )
             converged = 0;
             _sim_state = draining;
             _drain_time = _time;
+            Profiler::MarkDrain( );
             if(_stats_out) {
                 WriteStats(*_stats_out);
             }
@@ -1346,6 +1595,25 @@ bool TrafficManager::_SingleSim( )
         }
         ++total_phases;
 
+        if ( ( _checkpoint_save != "" ) && ( total_phases == _checkpoint_period ) ) {
+            CheckpointFile cp( _checkpoint_save, true );
+            _Checkpoint( cp );
+            cp.Io( prev_latency );
+            cp.Io( prev_accepted );
+            cp.Io( total_accepted_count );
+            cp.Io( prev_accepted_count );
+            cp.Io( total_phases );
+            cp.Io( num_no_accepted_flit_period );
+            cp.Io( converged );
+            cp.Io( clear_last );
+            cout << "Saved checkpoint " << _checkpoint_save << " at time " << _time << endl;
+            _checkpoint_save = "";
+            if ( _checkpoint_exit ) {
+                _sim_state = done;
+                return true;
+            }
+        }
+
         cout << endl;
     }
 
@@ -1355,6 +1623,7 @@ bool TrafficManager::_SingleSim( )
 
         _sim_state  = draining;
         _drain_time = _time;
+        Profiler::MarkDrain( );
 
         if ( _measure_latency ) {
             cout << GetSimTime() << ": Draining all recorded packets from injection queues."
@@ -1426,6 +1695,9 @@ bool TrafficManager::Run( )
     for ( int sim = 0; sim < _total_sims; ++sim ) {
 
         _time = 0;
+        if ( _telemetry ) {
+            _telemetry->Restart( );
+        }
 
         //remove any pending request from the previous simulations
         _requestsOutstanding.assign(_nodes, 0);
@@ -1465,6 +1737,11 @@ bool TrafficManager::Run( )
             return false;
         }
 
+        if ( _sim_state == done ) {
+            // stopped after writing the checkpoint
+            return true;
+        }
+
         if (!gShouldSkipDrain){
             // Empty any remaining packets
             cout << GetSimTime() << ": Draining remaining packets.  (All endpoints caught up.  Stopping generation of new packets.) ..." << endl;
@@ -1610,9 +1887,11 @@ void TrafficManager::_UpdateOverallStats() {
         _overall_min_plat[c] += _plat_stats[c]->Min();
         _overall_avg_plat[c] += _plat_stats[c]->Average();
         _overall_max_plat[c] += _plat_stats[c]->Max();
+        _overall_plat_stats[c]->Merge(*_plat_stats[c]);
         _overall_min_nlat[c] += _nlat_stats[c]->Min();
         _overall_avg_nlat[c] += _nlat_stats[c]->Average();
         _overall_max_nlat[c] += _nlat_stats[c]->Max();
+        _overall_nlat_stats[c]->Merge(*_nlat_stats[c]);
         _overall_min_first_nlat[c] += _first_nlat_stats[c]->Min();
         _overall_avg_first_nlat[c] += _first_nlat_stats[c]->Average();
         _overall_max_first_nlat[c] += _first_nlat_stats[c]->Max();
@@ -1895,9 +2174,15 @@ void TrafficManager::DisplayStats(ostream & os) const {
             << "Packet latency average = " << _plat_stats[c]->Average() << endl
             << "\tminimum = " << _plat_stats[c]->Min() << endl
             << "\tmaximum = " << _plat_stats[c]->Max() << endl
+            << "\tp50 = " << _plat_stats[c]->Percentile(0.5)
+            << ", p99 = " << _plat_stats[c]->Percentile(0.99)
+            << ", p999 = " << _plat_stats[c]->Percentile(0.999) << endl
             << "Network latency average = " << _nlat_stats[c]->Average() << endl
             << "\tminimum = " << _nlat_stats[c]->Min() << endl
             << "\tmaximum = " << _nlat_stats[c]->Max() << endl
+            << "\tp50 = " << _nlat_stats[c]->Percentile(0.5)
+            << ", p99 = " << _nlat_stats[c]->Percentile(0.99)
+            << ", p999 = " << _nlat_stats[c]->Percentile(0.999) << endl
             << "Slowest packet = " << _slowest_packet[c] << endl
 
             << "First inject to retire latency average = " << _first_nlat_stats[c]->Average() << endl
@@ -2017,6 +2302,10 @@ void TrafficManager::DisplayOverallStats( ostream & os ) const {
            << " (" << _total_sims << " samples)" << endl;
         os << "\tmaximum = " << _overall_max_plat[c] / (double)_total_sims
            << " (" << _total_sims << " samples)" << endl;
+        os << "\tp50 = " << _overall_plat_stats[c]->Percentile(0.5)
+           << ", p99 = " << _overall_plat_stats[c]->Percentile(0.99)
+           << ", p999 = " << _overall_plat_stats[c]->Percentile(0.999)
+           << " (" << _overall_plat_stats[c]->NumSamples() << " packets)" << endl;
 
         os << "Network latency average = " << _overall_avg_nlat[c] / (double)_total_sims
            << " (" << _total_sims << " samples)" << endl;
@@ -2024,6 +2313,10 @@ void TrafficManager::DisplayOverallStats( ostream & os ) const {
            << " (" << _total_sims << " samples)" << endl;
         os << "\tmaximum = " << _overall_max_nlat[c] / (double)_total_sims
            << " (" << _total_sims << " samples)" << endl;
+        os << "\tp50 = " << _overall_nlat_stats[c]->Percentile(0.5)
+           << ", p99 = " << _overall_nlat_stats[c]->Percentile(0.99)
+           << ", p999 = " << _overall_nlat_stats[c]->Percentile(0.999)
+           << " (" << _overall_nlat_stats[c]->NumSamples() << " packets)" << endl;
 
         os << "First inject to retire latency average = " << _overall_avg_first_nlat[c] / (double)_total_sims
            << " (" << _total_sims << " samples)" << endl;
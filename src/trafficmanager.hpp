@@ -43,6 +43,8 @@
 #include "routefunc.hpp"
 #include "outputset.hpp"
 #include "injection.hpp"
+#include "checkpoint.hpp"
+#include "telemetry.hpp"
 
 //register the requests to a node
 class PacketReplyInfo;
@@ -137,6 +139,9 @@ protected:
 
   int _subnets;
 
+  // steps the subnets concurrently when parallel_subnets is enabled
+  ParallelEngine * _subnet_engine;
+
   vector<int> _subnet;
 
   // ============ deadlock ==========
@@ -144,6 +149,23 @@ protected:
   int64_t _deadlock_timer;
   int64_t _deadlock_warn_timeout;
 
+  // ============ idle-cycle skipping ==========
+
+  bool _idle_skip;
+
+  // ============ checkpointing ==========
+
+  // file to save the state to after _checkpoint_period sample periods / to
+  // resume from (empty if unused)
+  string _checkpoint_save;
+  int _checkpoint_period;
+  string _checkpoint_restore;
+  // end the run once the checkpoint has been written
+  bool _checkpoint_exit;
+
+  // per-window counter time series, NULL unless telemetry_file is set
+  Telemetry * _telemetry;
+
   // ============ request & replies ==========================
 
   vector<int> _packet_seq_no;
@@ -156,11 +178,14 @@ protected:
   vector<double> _overall_min_plat;
   vector<double> _overall_avg_plat;
   vector<double> _overall_max_plat;
+  // all packets of all simulations, for the overall percentiles
+  vector<Stats *> _overall_plat_stats;
 
   vector<Stats *> _nlat_stats;
   vector<double> _overall_min_nlat;
   vector<double> _overall_avg_nlat;
   vector<double> _overall_max_nlat;
+  vector<Stats *> _overall_nlat_stats;
 
   vector<Stats *> _first_nlat_stats;
   vector<double> _overall_min_first_nlat;
@@ -291,6 +316,12 @@ protected:
 
   void _Step( );
 
+  // Runs one cycle, or fast-forwards over up to max_cycles cycles in which
+  // nothing can happen; returns the number of cycles that elapsed.
+  int64_t _Advance( int64_t max_cycles );
+  int64_t _NextEventTime( );
+  void _SkipIdleCycles( int64_t cycles );
+
   bool _InjectionsOutstanding( ) const;
   bool _EndPointProcessingOutstanding() const;
 
@@ -301,6 +332,10 @@ protected:
 
   virtual bool _SingleSim( );
 
+  // Saves or restores the complete simulation state (traffic manager,
+  // statistics, networks, endpoints, flits and random number generators).
+  void _Checkpoint( CheckpointFile & cp );
+
   void _DisplayRemaining( ostream & os = cout ) const;
 
   void _LoadWatchList(const string & filename);
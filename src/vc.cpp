@@ -47,11 +47,15 @@ const char * const VC::VCSTATE[] = {"idle",
 const int VC::VCSTATE_LEN = 4;
 
 VC::VC( const Configuration& config, int outputs,
-	Module *parent, const string& name )
+	Module *parent, const string& name,
+	Flit::Handle * ring, int capacity )
   : Module( parent, name ),
+    _ring(ring), _mask(capacity - 1), _head(0), _count(0),
     _state(idle), _out_port(-1), _out_vc(-1), _pri(0), _watched(false),
     _expected_pid(-1), _last_id(-1), _last_pid(-1)
 {
+  assert( ( capacity > 0 ) && ( ( capacity & _mask ) == 0 ) );
+
   _lookahead_routing = !config.GetInt("routing_delay");
   _route_set = _lookahead_routing ? NULL : new OutputSet( );
 
@@ -104,16 +108,21 @@ void VC::AddFlit( Flit *f )
     assert(f->pri >= 0);
   }
 
-  _buffer.push_back(f);
+  if ( _count > _mask ) {
+    _Grow( );
+  }
+  _ring[( _head + _count ) & _mask] = f->GetHandle();
+  ++_count;
   UpdatePriority();
 }
 
 Flit *VC::RemoveFlit( )
 {
   Flit *f = NULL;
-  if ( !_buffer.empty( ) ) {
-    f = _buffer.front( );
-    _buffer.pop_front( );
+  if ( _count ) {
+    f = Flit::FromHandle(_ring[_head]);
+    _head = ( _head + 1 ) & _mask;
+    --_count;
     _last_id = f->id;
     _last_pid = f->pid;
     UpdatePriority();
@@ -125,6 +134,18 @@ Flit *VC::RemoveFlit( )
 
 
 
+void VC::_Grow( )
+{
+  vector<Flit::Handle> ring( 2 * ( _mask + 1 ) );
+  for ( int i = 0; i < _count; ++i ) {
+    ring[i] = _At(i);
+  }
+  _overflow.swap( ring );
+  _ring = &_overflow[0];
+  _mask = _overflow.size( ) - 1;
+  _head = 0;
+}
+
 void VC::SetState( eVCState s )
 {
   Flit * f = FrontFlit();
@@ -157,15 +178,15 @@ void VC::SetOutput( int port, int vc )
 
 void VC::UpdatePriority()
 {
-  if(_buffer.empty()) return;
+  if(_count == 0) return;
   if(_pri_type == queue_length_based) {
-    _pri = _buffer.size();
+    _pri = _count;
   } else if(_pri_type != none) {
-    Flit * f = _buffer.front();
+    Flit * f = Flit::FromHandle(_ring[_head]);
     if((_pri_type != local_age_based) && _priority_donation) {
       Flit * df = f;
-      for(size_t i = 1; i < _buffer.size(); ++i) {
-	Flit * bf = _buffer[i];
+      for(int i = 1; i < _count; ++i) {
+	Flit * bf = Flit::FromHandle(_At(i));
 	if(bf->pri > df->pri) df = bf;
       }
       if((df != f) && (df->watch || f->watch)) {
@@ -193,6 +214,46 @@ void VC::Route( tRoutingFunction rf, const Router* router, const Flit* f, int in
   _out_vc = -1;
 }
 
+void VC::Checkpoint( CheckpointFile & cp )
+{
+  // saved front to back, the same as the former deque
+  vector<Flit::Handle> flits;
+  if ( cp.IsSaving( ) ) {
+    for ( int i = 0; i < _count; ++i ) {
+      flits.push_back( _At(i) );
+    }
+  }
+  cp.Io( flits );
+  if ( !cp.IsSaving( ) ) {
+    _head = 0;
+    _count = 0;
+    while ( (int)flits.size( ) > _mask + 1 ) {
+      _Grow( );
+    }
+    for ( size_t i = 0; i < flits.size( ); ++i ) {
+      _ring[i] = flits[i];
+    }
+    _count = flits.size( );
+  }
+  cp.Io( _state );
+  if ( _lookahead_routing ) {
+    // The route set then belongs to a flit, which the routers that use it
+    // do not support checkpointing anyway.
+    if ( _route_set ) {
+      cp.Error( FullName( ) + " holds a lookahead route set" );
+    }
+  } else {
+    cp.Io( *_route_set );
+  }
+  cp.Io( _out_port );
+  cp.Io( _out_vc );
+  cp.Io( _pri );
+  cp.Io( _watched );
+  cp.Io( _expected_pid );
+  cp.Io( _last_id );
+  cp.Io( _last_pid );
+}
+
 // ==== Debug functions ====
 
 void VC::SetWatch( bool watch )
@@ -214,9 +275,9 @@ void VC::Display( ostream & os ) const
       os << " out_port: " << _out_port
 	 << " out_vc: " << _out_vc;
     }
-    os << " fill: " << _buffer.size();
-    if(!_buffer.empty()) {
-      os << " front: " << _buffer.front()->id;
+    os << " fill: " << _count;
+    if(_count) {
+      os << " front: " << Flit::FromHandle(_ring[_head])->id;
     }
     os << " pri: " << _pri;
     os << endl;
@@ -28,10 +28,11 @@
 #ifndef _VC_HPP_
 #define _VC_HPP_
 
-#include <deque>
+#include <vector>
 
 #include "flit.hpp"
 #include "outputset.hpp"
+#include "checkpoint.hpp"
 #include "routefunc.hpp"
 #include "config_utils.hpp"
 
@@ -47,7 +48,20 @@ public:
 
 private:
 
-  deque<Flit *> _buffer;
+  // The flits are kept in a ring of _mask + 1 (a power of two) handles,
+  // normally a slice of the owning Buffer's slab. A VC that outgrows it
+  // under a shared buffer policy moves to _overflow, which doubles as needed.
+  Flit::Handle * _ring;
+  int _mask;
+  int _head;
+  int _count;
+  vector<Flit::Handle> _overflow;
+
+  void _Grow( );
+  inline Flit::Handle _At( int i ) const
+  {
+    return _ring[( _head + i ) & _mask];
+  }
 
   eVCState _state;
 
@@ -73,14 +87,16 @@ private:
 
 public:
 
+  // ring points to capacity (a power of two) handles owned by the caller
   VC( const Configuration& config, int outputs,
-      Module *parent, const string& name );
+      Module *parent, const string& name,
+      Flit::Handle * ring, int capacity );
   ~VC();
 
   void AddFlit( Flit *f );
   inline Flit *FrontFlit( ) const
   {
-    return _buffer.empty() ? NULL : _buffer.front();
+    return _count ? Flit::FromHandle(_ring[_head]) : NULL;
   }
 
   Flit *RemoveFlit( );
@@ -88,7 +104,7 @@ public:
 
   inline bool Empty( ) const
   {
-    return _buffer.empty( );
+    return _count == 0;
   }
 
   inline VC::eVCState GetState( ) const
@@ -125,9 +141,11 @@ public:
 
   inline int GetOccupancy() const
   {
-    return (int)_buffer.size();
+    return _count;
   }
 
+  void Checkpoint( CheckpointFile & cp );
+
   // ==== Debug functions ====
 
   void SetWatch( bool watch = true );
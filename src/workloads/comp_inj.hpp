@@ -29,8 +29,10 @@ class ComponentInjectionProcess : public InjectionProcess {
     WorkloadMessagePtr get(int src)  { if(src < active_nodes) return _upstream->get(src); else return NULL; }
     void next(int src)               { if(src < active_nodes ) _upstream->next(src); }
     void eject(WorkloadMessagePtr m) { _upstream->eject(m); }
+    int64_t ready_time(int src)      { if(src < active_nodes) return _upstream->ready_time(src); else return INT64_MAX; }
 
 	ComponentInjectionProcess(int nodes, const string& params, Configuration const * const config);
+    ~ComponentInjectionProcess()     { delete _upstream; }
 
     typedef pair<string, vector<string> > comp_spec_t;          // component specifier: kind, options
     static vector<comp_spec_t> ParseComponents(const string &); // parse components string
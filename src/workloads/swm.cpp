@@ -7,6 +7,7 @@
  *      Author: cjbeckma
  */
 #include <swm.hpp>
+#include "profiler.hpp"
 
 //
 // the SWM thread class implementation
@@ -245,6 +246,7 @@ void SwmThread::SwmEndMarker(int marker)
    inline
 void SwmThread::go(cycle_t now)
 {
+   PROFILE_PHASE( SWM_RESUME );
    _state = ready;
    _time = now;
    (*_coro)(); // resume the coroutine
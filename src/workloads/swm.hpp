@@ -86,6 +86,7 @@ class SwmThread : public GeneratorWorkloadMessage::Factory, pt::Traceable {
     int       get_id() const                       { return _me; }
     int       get_num_pes() const                  { return _np; }
     bool      has_packet(cycle_t now) const        { return _state == message && _time <= now; }
+    cycle_t   next_packet_time() const             { return _state == message ? _time : ~cycle_t(0); }
     WorkloadMessagePtr get_packet() const          { return _coro->get(); }
     void      next(cycle_t);                       // after getting outgoing packet, run and generate next packet
     void      reply(cycle_t, WorkloadMessagePtr);  // provide reply and run
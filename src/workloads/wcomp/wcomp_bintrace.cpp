@@ -0,0 +1,257 @@
+/*
+ * workload components for capturing and replaying binary message traces
+ *
+ * A trace file holds one fixed-size record per injected message, stored in
+ * blocks of records from a single source node:
+ *
+ *   header     "BSTRACE1", int64 nodes, records, directory offset, blocks
+ *   blocks     TRACE_BLOCK_RECORDS (or fewer) TraceRecords each
+ *   directory  one TraceBlock per block, in file order
+ *
+ * Blocks of one node appear in time order, so replay walks each node's
+ * blocks with its own cursor straight out of a memory mapping of the file;
+ * only the directory is read into memory.
+ */
+#include "globals.hpp"
+#include "wkld_comp.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+char const TRACE_MAGIC[8] = { 'B', 'S', 'T', 'R', 'A', 'C', 'E', '1' };
+
+// records buffered per node by the capture component before a block is written
+int const TRACE_BLOCK_RECORDS = 128;
+
+struct TraceHeader {
+    char    magic[8];
+    int64_t nodes;
+    int64_t records;
+    int64_t directory;  // file offset of the block directory, 0 while capturing
+    int64_t blocks;
+};
+
+struct TraceRecord {
+    int64_t time;       // cycle at which the message was injected
+    int32_t src;
+    int32_t dest;
+    int32_t size;
+    int32_t payload_size;
+    int32_t type;       // WorkloadMessage::msg_t
+    int32_t reply;
+};
+
+struct TraceBlock {
+    int64_t offset;     // file offset of the first record
+    int32_t node;
+    int32_t count;
+};
+
+}
+
+//////////////////
+// Binary trace capture - traffic modifier.
+// Passes all traffic through unchanged and records every message the
+// endpoints inject. Options are: output file name.
+class TraceCapture : public WComp<TraceCapture>
+{
+    FILE * _file;
+    string _filename;
+    TraceHeader _header;
+    vector<vector<TraceRecord> > _pending;   // per node, not yet written
+    vector<TraceBlock> _directory;
+
+    void _write_block(int node) {
+        vector<TraceRecord> & recs = _pending[node];
+        if (recs.empty()) return;
+        TraceBlock b;
+        b.offset = ftell(_file);
+        b.node = node;
+        b.count = recs.size();
+        fwrite(&recs[0], sizeof(TraceRecord), recs.size(), _file);
+        _directory.push_back(b);
+        recs.clear();
+    }
+  public:
+    TraceCapture(int nodes, const vector<string> &options, Configuration const * const config, WorkloadComponent *upstrm)
+      : WComp<TraceCapture>(upstrm), _file(0)
+    {
+        assert(_upstream);
+        if (options.size() != 1) {
+            std::cerr << "capture needs one option, the trace file name" << std::endl;
+            ::exit(-2);
+        }
+        _filename = options[0];
+        _file = fopen(_filename.c_str(), "wb");
+        if (!_file) {
+            std::cerr << "cannot create trace file " << _filename << std::endl;
+            ::exit(-2);
+        }
+        memset(&_header, 0, sizeof(_header));
+        memcpy(_header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+        fwrite(&_header, sizeof(_header), 1, _file);
+    }
+    ~TraceCapture() {
+        // flush the partial blocks, then the directory, then the final header
+        for (size_t n = 0; n < _pending.size(); ++n)
+            _write_block(n);
+        _header.directory = ftell(_file);
+        _header.blocks = _directory.size();
+        if (!_directory.empty())
+            fwrite(&_directory[0], sizeof(TraceBlock), _directory.size(), _file);
+        fseek(_file, 0, SEEK_SET);
+        fwrite(&_header, sizeof(_header), 1, _file);
+        if (fclose(_file) != 0)
+            std::cerr << "writing trace file " << _filename << " failed" << std::endl;
+    }
+
+    void Init(int pes, Configuration const * const config) {
+        _upstream->Init(pes, config);
+        _header.nodes = pes;
+        _pending.resize(pes);
+        for (auto & p : _pending) p.reserve(TRACE_BLOCK_RECORDS);
+    }
+
+    bool test(int src)                 { return _upstream->test(src); }
+    int64_t ready_time(int src)        { return _upstream->ready_time(src); }
+    WorkloadMessagePtr get(int src)    { return _upstream->get(src); }
+    void eject(WorkloadMessagePtr m)   { _upstream->eject(m); }
+
+    void next(int src) {
+        // the endpoint calls next() once it has taken the message from get()
+        WorkloadMessagePtr m = _upstream->get(src);
+        TraceRecord r;
+        r.time = GetSimTime();
+        r.src = m->Source();
+        r.dest = m->Dest();
+        r.size = m->Size();
+        r.payload_size = m->PayloadSize();
+        r.type = m->Type();
+        r.reply = m->IsReply();
+        _pending[src].push_back(r);
+        ++_header.records;
+        if ((int)_pending[src].size() >= TRACE_BLOCK_RECORDS)
+            _write_block(src);
+        _upstream->next(src);
+    }
+};
+
+PUBLISH_WORKLOAD_COMPONENT(TraceCapture, "capture");
+
+//////////////////
+// Binary trace replay - traffic generator.
+// Injects every recorded message at its recorded cycle (or as soon after as
+// the endpoint accepts it), independent of when earlier messages are
+// delivered. The simulation ends when all records have been injected.
+// Options are: trace file name.
+class TraceReplay : public WComp<TraceReplay>,
+                    private GeneratorWorkloadMessage::Factory
+{
+    struct Cursor {
+        vector<int64_t> blocks;         // indices into the directory
+        size_t block;                   // current block
+        int record;                     // current record within the block
+    };
+
+    string _filename;
+    char const * _map;
+    size_t _map_size;
+    TraceHeader _header;
+    vector<TraceBlock> _directory;
+    vector<Cursor> _cursor;
+    int _active;                        // nodes with records left
+
+    TraceRecord const * _head(int src) const {
+        Cursor const & c = _cursor[src];
+        if (c.block >= c.blocks.size()) return 0;
+        TraceBlock const & b = _directory[c.blocks[c.block]];
+        return reinterpret_cast<TraceRecord const *>(_map + b.offset) + c.record;
+    }
+    void _error(char const * what) {
+        std::cerr << "trace file " << _filename << ": " << what << std::endl;
+        ::exit(-2);
+    }
+  public:
+    TraceReplay(int nodes, const vector<string> &options, Configuration const * config, WorkloadComponent *upstrm)
+      : WComp<TraceReplay>(upstrm),
+        GeneratorWorkloadMessage::Factory(config, gInjectorTrafficClass),
+        _map(0), _map_size(0), _active(0)
+    {
+        if (options.size() != 1) {
+            std::cerr << "replay needs one option, the trace file name" << std::endl;
+            ::exit(-2);
+        }
+        _filename = options[0];
+        int fd = open(_filename.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) _error("cannot open");
+        _map_size = st.st_size;
+        if (_map_size < sizeof(TraceHeader)) _error("too short");
+        void * m = mmap(0, _map_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (m == MAP_FAILED) _error("cannot map");
+        _map = static_cast<char const *>(m);
+
+        memcpy(&_header, _map, sizeof(_header));
+        if (memcmp(_header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0) _error("not a trace file");
+        if (_header.directory == 0) _error("incomplete, the capturing run did not finish");
+        if ((size_t)(_header.directory + _header.blocks * sizeof(TraceBlock)) > _map_size) _error("truncated");
+        _directory.resize(_header.blocks);
+        if (_header.blocks > 0)
+            memcpy(&_directory[0], _map + _header.directory, _header.blocks * sizeof(TraceBlock));
+
+        // replayed messages come from the trace rather than the traffic pattern
+        gSwm = true;
+        gSimEnabled = true;
+    }
+    ~TraceReplay() {
+        if (_map) munmap(const_cast<char *>(_map), _map_size);
+    }
+
+    void Init(int pes, Configuration const * const config) {
+        WorkloadComponent::Init(pes, config);
+        if (_header.nodes > pes) _error("recorded with more nodes than simulated");
+        _cursor.resize(pes);
+        for (int64_t i = 0; i < _header.blocks; ++i)
+            _cursor[_directory[i].node].blocks.push_back(i);
+        for (auto & c : _cursor) {
+            c.block = 0;
+            c.record = 0;
+            if (!c.blocks.empty()) ++_active;
+        }
+        if (_active == 0) gSimEnabled = false;
+    }
+
+    bool test(int src) {
+        TraceRecord const * r = _head(src);
+        return r && r->time <= GetSimTime();
+    }
+    int64_t ready_time(int src) {
+        TraceRecord const * r = _head(src);
+        return r ? r->time : INT64_MAX;
+    }
+    void next(int src) {
+        WorkloadComponent::next(src); // required
+        Cursor & c = _cursor[src];
+        if (++c.record >= _directory[c.blocks[c.block]].count) {
+            ++c.block;
+            c.record = 0;
+            if (c.block >= c.blocks.size() && --_active == 0)
+                gSimEnabled = false;
+        }
+    }
+  private:
+    WorkloadMessagePtr _get_new(int src) {
+        TraceRecord const * r = _head(src);
+        assert(r && r->src == src);
+        return new GeneratorWorkloadMessage(this, src, r->dest, (msg_t)r->type, r->reply != 0,
+                                            r->size, r->payload_size);
+    }
+};
+
+PUBLISH_WORKLOAD_COMPONENT(TraceReplay, "replay");
@@ -57,6 +57,12 @@ class LocalShortcut : public WComp<LocalShortcut>
         WorkloadComponent::next(src);
         _upstream->next(src);
     }
+    int64_t ready_time(int src) {
+        int64_t t = _upstream->ready_time(src);
+        if (!_local_inflight.empty() && _local_inflight.back().second < t)
+            t = _local_inflight.back().second;
+        return t;
+    }
     void eject(WorkloadMessagePtr m) {
         _upstream->eject(m);
     }
@@ -77,6 +77,17 @@ class MppnEndpoint : public WComp<MppnEndpoint>
     }
   }
 
+  int64_t ready_time(int src) {
+    if(!_is_pe_info_list_empty(src)) {
+      return GetSimTime();
+    }
+    int64_t t = INT64_MAX;
+    for(int i=0; i<_pe_per_node; ++i) {
+      t = std::min(t, _upstream->ready_time(_pe_begin(src) + i));
+    }
+    return t;
+  }
+
   WorkloadMessagePtr _get_new(int src)
   {
     auto pe_info  = _get_pe_info(src);
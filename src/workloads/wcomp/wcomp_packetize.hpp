@@ -33,6 +33,7 @@ class Packetize : public WComp<Packetize>
     Packetize(int nodes, const vector<string> &options, Configuration const * const config, WorkloadComponent * upstrm);
     void Init(int nodes, Configuration const * const config) { _upstream->Init(nodes, config); }
     bool test(int src) { return _upstream->test(src); }
+    int64_t ready_time(int src) { return _upstream->ready_time(src); }
     WorkloadMessagePtr _get_new(int src) { return new Message(_upstream->get(src)); }
     void next(int src);
     void eject(WorkloadMessagePtr m);
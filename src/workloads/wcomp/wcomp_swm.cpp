@@ -86,6 +86,12 @@ class ScalableWorkloadModel : public WComp<ScalableWorkloadModel>, RoI,
 
       WorkloadComponent::next(src);
    }
+   int64_t ready_time(int src)
+   {
+      if (!_replies_pending[src].empty()) return GetSimTime();
+      SwmThread::cycle_t t = _thread[src]->next_packet_time();
+      return (t > (SwmThread::cycle_t)INT64_MAX) ? INT64_MAX : (int64_t)t;
+   }
    void eject(WorkloadMessagePtr m)
    {
       int  dest = m->Dest();
@@ -62,6 +62,10 @@ class WorkloadTrafficTrace : public WComp<WorkloadTrafficTrace>
         if (_trace_test) *_ostrm << " returning " << r << std::endl;
         return r;
     }
+    int64_t ready_time(int src) {
+        // every traced test() call must show up in the trace
+        return _trace_test ? GetSimTime() : _upstream->ready_time(src);
+    }
 
     WorkloadMessagePtr get(int src) {
         if (_trace_get) *_ostrm << _get_time_str() << "get(" << src << ")";
@@ -7,6 +7,7 @@
 #pragma once
 
 #include <assert.h>
+#include <stdint.h>
 #include <vector>
 #include <string>
 #include <swm.hpp>
@@ -41,11 +42,15 @@ class WorkloadComponent
       }
       virtual void next(int src) { _last_get[src] = 0; }; // derived class next() must call this unless overriding get()
       virtual void eject(WorkloadMessagePtr m) {};
+      // earliest cycle at which test(src) may return true or change any state
+      // (INT64_MAX if never without an eject()). Used to skip idle cycles; the
+      // default, the current cycle, keeps the simulator stepping every cycle.
+      virtual int64_t ready_time(int src) { return GetSimTime(); }
 
       virtual void Init(int pes, Configuration const *) { _last_get.resize(pes, 0); };
       virtual void FunctionalSim() {};
       static WorkloadComponent* New(const string &, int, const vector<string> &, Configuration const *, WorkloadComponent *);
-      virtual ~WorkloadComponent() = default;
+      virtual ~WorkloadComponent() { delete _upstream; } // a component owns the chain upstream of it
 
       // get an upstream component of the given type (if none, return NULL)
       template <class T> T * ComponentOfType() {
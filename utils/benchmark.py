@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+
+# Simulator throughput benchmarks.
+#
+# Runs a fixed set of configurations (topologies from runfiles/, the iq,
+# lossy_oq and lossy routers, synthetic and SWM traffic) and reports for each
+# the simulated cycles per second, delivered flits per second and peak
+# resident set size, one JSON record per line. Every case generates traffic
+# for a fixed number of cycles (--cycles) and then drains the network. The
+# rates are those of the measured window, i.e. the fixed traffic generation
+# cycles; the drain, whose length varies from run to run, is reported apart
+# (drain_cycles, drain_seconds).
+#
+# usage: benchmark.py [--booksim PATH] [--cycles N] [--repeat N]
+#                     [--output FILE] [--baseline FILE] [--tolerance F]
+#                     [CASE-PATTERN...]
+#
+# With --baseline, cycles/s of every case is compared against a previous
+# output file and the script fails if any case is slower by more than the
+# tolerance (default 0.1, i.e. 10%).
+
+import argparse
+import fnmatch
+import json
+import os
+import re
+import subprocess
+import sys
+import time
+
+RUNFILES = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'runfiles')
+
+# Settings shared by all cases: no warm-up, one sample period, rate reporting.
+COMMON = ['warmup_periods=0', 'max_samples=1', 'profile=1',
+          'use_endpoint_crediting=0', 'injection_rate=0.02']
+
+MESH = ['meshconfig']
+TORUS = ['meshconfig', 'topology=torus', 'routing_function=dim_order']
+DRAGONFLY = ['dragonflyconfig', 'k=2']
+FATTREE = ['ftreeconfig']
+
+# The lossy_oq router supports a single VC per port (two on the torus, which
+# needs them for deadlock-free dimension-order routing); the iq router gets
+# deep buffers since endpoints do not wait for credits. The input-queued
+# lossy router ("lossyiq") keeps the runfiles' VCs and buffers; it
+# interleaves the flits of multi-flit packets, so it gets no SWM cases.
+LOSSY = ['router=lossy_oq', 'num_vcs=1']
+LOSSY_IQ = ['router=lossy']
+IQ = ['router=iq', 'num_vcs=1', 'vc_buf_size=1024']
+
+
+def swm(workload):
+    return ['injection_process=component(SWM(%s))' % workload]
+
+
+CASES = [
+    ('mesh_lossy_uniform',       MESH + LOSSY),
+    ('mesh_iq_uniform',          MESH + IQ),
+    ('torus_lossy_uniform',      TORUS + LOSSY + ['num_vcs=2']),
+    ('torus_iq_uniform',         TORUS + IQ + ['num_vcs=2']),
+    ('dragonfly_lossy_uniform',  DRAGONFLY + LOSSY),
+    ('dragonfly_iq_uniform',     DRAGONFLY + IQ + ['num_vcs=3']),
+    ('fattree_lossy_uniform',    FATTREE + LOSSY),
+    ('fattree_iq_uniform',       FATTREE + IQ),
+    ('mesh_lossyiq_uniform',     MESH + LOSSY_IQ),
+    ('torus_lossyiq_uniform',    TORUS + LOSSY_IQ),
+    ('dragonfly_lossyiq_uniform', DRAGONFLY + LOSSY_IQ),
+    ('fattree_lossyiq_uniform',  FATTREE + LOSSY_IQ),
+    ('mesh_lossy_swm_randperm',  MESH + LOSSY + swm('randperm')),
+    ('mesh_lossy_swm_allreduce', MESH + LOSSY + swm('allreduce')),
+    ('mesh_iq_swm_allreduce',    MESH + IQ + swm('allreduce')),
+    ('fattree_lossy_swm_histo',  FATTREE + LOSSY + swm('histo')),
+]
+
+RATE_RE = {
+    'cycles': re.compile(r'^Simulated cycles = (\d+)', re.M),
+    'flits': re.compile(r'^Delivered flits = (\d+)', re.M),
+    'seconds': re.compile(r'^Total run time = ([0-9.eE+-]+)', re.M),
+}
+WINDOW_RE = re.compile(r'^Measured window = (\d+) cycles, (\d+) flits, ([0-9.eE+-]+) s', re.M)
+DRAIN_RE = re.compile(r'^Drain = (\d+) cycles, (\d+) flits, ([0-9.eE+-]+) s', re.M)
+
+
+def run_case(booksim, name, args, cycles):
+    runfile = os.path.join(RUNFILES, args[0])
+    cmd = [booksim, runfile] + args[1:] + COMMON + ['sample_period=%d' % cycles]
+    start = time.time()
+    proc = subprocess.Popen(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    output = proc.stdout.read().decode(errors='replace')
+    _, status, usage = os.wait4(proc.pid, 0)
+    proc.returncode = status
+    record = {'case': name, 'wall_seconds': time.time() - start,
+              'peak_rss_kb': usage.ru_maxrss}
+    for key, regex in RATE_RE.items():
+        m = regex.search(output)
+        if m:
+            record[key] = float(m.group(1)) if key == 'seconds' else int(m.group(1))
+    for prefix, regex in (('window', WINDOW_RE), ('drain', DRAIN_RE)):
+        m = regex.search(output)
+        if m:
+            record[prefix + '_cycles'] = int(m.group(1))
+            record[prefix + '_flits'] = int(m.group(2))
+            record[prefix + '_seconds'] = float(m.group(3))
+    ok = 'Simulation = PASSED!' in output and record.get('window_seconds', 0) > 0
+    record['status'] = 'passed' if ok else 'failed'
+    if ok:
+        record['cycles_per_second'] = record['window_cycles'] / record['window_seconds']
+        record['flits_per_second'] = record['window_flits'] / record['window_seconds']
+    else:
+        record['log_tail'] = output.splitlines()[-5:]
+    return record
+
+
+def main():
+    parser = argparse.ArgumentParser(description='BookSim throughput benchmarks')
+    parser.add_argument('--booksim', default=os.path.join(os.path.dirname(
+        os.path.abspath(__file__)), '..', 'src', 'booksim'))
+    parser.add_argument('--cycles', type=int, default=5000,
+                        help='cycles of traffic generation per case')
+    parser.add_argument('--repeat', type=int, default=1,
+                        help='runs per case; the fastest one is reported')
+    parser.add_argument('--output', help='file for the JSON records (default stdout)')
+    parser.add_argument('--baseline', help='JSON records of an earlier run to compare with')
+    parser.add_argument('--tolerance', type=float, default=0.1)
+    parser.add_argument('--list', action='store_true', help='list the cases and exit')
+    parser.add_argument('patterns', nargs='*', help='run only matching cases')
+    opts = parser.parse_args()
+
+    cases = [(n, a) for n, a in CASES
+             if not opts.patterns or any(fnmatch.fnmatchcase(n, p) for p in opts.patterns)]
+    if opts.list:
+        for name, args in cases:
+            print('%-26s %s' % (name, ' '.join(args)))
+        return 0
+
+    baseline = {}
+    if opts.baseline:
+        with open(opts.baseline) as f:
+            for line in f:
+                if line.strip():
+                    r = json.loads(line)
+                    baseline[r['case']] = r
+
+    out = open(opts.output, 'w') if opts.output else sys.stdout
+    failed = False
+    for name, args in cases:
+        best = None
+        for _ in range(opts.repeat):
+            r = run_case(opts.booksim, name, args, opts.cycles)
+            if r['status'] != 'passed':
+                best = r
+                break
+            if best is None or r['cycles_per_second'] > best['cycles_per_second']:
+                best = r
+        note = ''
+        if best['status'] != 'passed':
+            failed = True
+            note = 'FAILED'
+        elif name in baseline and baseline[name].get('status') == 'passed':
+            ratio = best['cycles_per_second'] / baseline[name]['cycles_per_second']
+            best['baseline_ratio'] = ratio
+            note = '%+.1f%% vs baseline' % (100.0 * (ratio - 1.0))
+            if ratio < 1.0 - opts.tolerance:
+                failed = True
+                note += ' REGRESSION'
+        out.write(json.dumps(best, sort_keys=True) + '\n')
+        out.flush()
+        sys.stderr.write('%-26s %12s cycles/s %12s flits/s %8s s drain %8s MB  %s\n' % (
+            name,
+            '%.0f' % best['cycles_per_second'] if 'cycles_per_second' in best else '-',
+            '%.0f' % best['flits_per_second'] if 'flits_per_second' in best else '-',
+            '%.2f' % best['drain_seconds'] if 'drain_seconds' in best else '-',
+            '%.1f' % (best['peak_rss_kb'] / 1024.0), note))
+    if out is not sys.stdout:
+        out.close()
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+
+# Reader and writer for the binary message traces of the capture and replay
+# workload components.
+#
+# usage: bintrace.py FILE                  print the header
+#        bintrace.py FILE csv              dump records as CSV, by node
+#        bintrace.py FILE pack CSV NODES   write FILE from a CSV with columns
+#                                          time,src,dest,size,payload_size,type,reply
+#
+# type is the WorkloadMessage::msg_t value (0 = any, 1 = get, 2 = put, ...).
+# Packing reads the whole CSV into memory; it is meant for traces produced
+# by other tools, not for the multi-gigabyte ones the simulator captures.
+
+import csv
+import struct
+import sys
+
+MAGIC = b'BSTRACE1'
+HEADER = struct.Struct('=8sqqqq')    # magic, nodes, records, directory offset, blocks
+RECORD = struct.Struct('=qiiiiii')   # time, src, dest, size, payload_size, type, reply
+BLOCK = struct.Struct('=qii')        # offset, node, count
+BLOCK_RECORDS = 128
+
+
+def read_header(f):
+    magic, nodes, records, directory, blocks = HEADER.unpack(f.read(HEADER.size))
+    if magic != MAGIC:
+        raise ValueError('not a trace file')
+    if directory == 0:
+        raise ValueError('incomplete trace file')
+    return nodes, records, directory, blocks
+
+
+def records(filename):
+    """Yields the records of each node in turn, in time order."""
+    with open(filename, 'rb') as f:
+        nodes, count, directory, blocks = read_header(f)
+        f.seek(directory)
+        by_node = {}
+        for _ in range(blocks):
+            offset, node, n = BLOCK.unpack(f.read(BLOCK.size))
+            by_node.setdefault(node, []).append((offset, n))
+        for node in sorted(by_node):
+            for offset, n in by_node[node]:
+                f.seek(offset)
+                data = f.read(n * RECORD.size)
+                for i in range(n):
+                    yield RECORD.unpack_from(data, i * RECORD.size)
+
+
+def pack(filename, csvname, nodes):
+    per_node = [[] for _ in range(nodes)]
+    with open(csvname) as f:
+        for row in csv.reader(f):
+            if not row or not row[0].strip().lstrip('-').isdigit():
+                continue    # header or blank line
+            r = tuple(int(v) for v in row[:7])
+            per_node[r[1]].append(r)
+    with open(filename, 'wb') as f:
+        f.write(HEADER.pack(MAGIC, nodes, 0, 0, 0))
+        directory = []
+        total = 0
+        for node, recs in enumerate(per_node):
+            recs.sort(key=lambda r: r[0])
+            for i in range(0, len(recs), BLOCK_RECORDS):
+                chunk = recs[i:i + BLOCK_RECORDS]
+                directory.append((f.tell(), node, len(chunk)))
+                for r in chunk:
+                    f.write(RECORD.pack(*r))
+                total += len(chunk)
+        offset = f.tell()
+        for b in directory:
+            f.write(BLOCK.pack(*b))
+        f.seek(0)
+        f.write(HEADER.pack(MAGIC, nodes, total, offset, len(directory)))
+
+
+def main(argv):
+    if len(argv) < 2:
+        sys.stderr.write('usage: bintrace.py FILE [csv | pack CSV NODES]\n')
+        return 1
+    filename = argv[1]
+    command = argv[2] if len(argv) > 2 else 'info'
+
+    if command == 'info':
+        with open(filename, 'rb') as f:
+            nodes, count, directory, blocks = read_header(f)
+        print('nodes = %d, records = %d, blocks = %d' % (nodes, count, blocks))
+    elif command == 'csv':
+        print('time,src,dest,size,payload_size,type,reply')
+        for r in records(filename):
+            print(','.join(str(v) for v in r))
+    elif command == 'pack' and len(argv) == 5:
+        pack(filename, argv[3], int(argv[4]))
+    else:
+        sys.stderr.write('unknown command %s\n' % command)
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
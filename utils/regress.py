@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+
+# Simulator regression checks.
+#
+# Runs a small set of configurations from runfiles/ and checks properties
+# that do not depend on the exact numbers simulated, e.g. that the parallel
+# engine reproduces the serial one. Prints one line per check and fails if
+# any check fails.
+#
+# usage: regress.py [--booksim PATH] [--list] [CHECK-PATTERN...]
+
+import argparse
+import fnmatch
+import os
+import re
+import subprocess
+import sys
+
+RUNFILES = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'runfiles')
+
+# Short runs at a load every topology below sustains.
+COMMON = ['warmup_periods=0', 'max_samples=1', 'sample_period=2000',
+          'use_endpoint_crediting=0', 'injection_rate=0.02', 'seed=7']
+
+# The fat tree's nca routing picks a random up port in every router.
+FATTREE_RANDOM = ['ftreeconfig', 'router=lossy_oq', 'num_vcs=1', 'random_streams=1']
+
+MESH_IQ = ['meshconfig', 'router=iq', 'vc_buf_size=1024']
+MESH_LOSSY = ['meshconfig', 'router=lossy_oq', 'num_vcs=1']
+
+# Lines that legitimately differ between runs of the same simulation.
+VOLATILE_RE = re.compile(r'^(OVERRIDE Parameter: |Total run time = |Profile)')
+
+
+def run(booksim, args):
+    cmd = [booksim, os.path.join(RUNFILES, args[0])] + args[1:]
+    proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    return proc.stdout.decode(errors='replace')
+
+
+# main() exits with a non-zero status on success, so only the log counts.
+def passed(output):
+    return 'Simulation = PASSED!' in output
+
+
+def results(output):
+    return [l for l in output.splitlines() if not VOLATILE_RE.match(l)]
+
+
+def check_same(booksim, args, serial, parallel):
+    a = run(booksim, args + COMMON + serial)
+    b = run(booksim, args + COMMON + parallel)
+    if not passed(a) or not passed(b):
+        return 'simulation failed'
+    if results(a) != results(b):
+        return '%s differs from %s' % (' '.join(parallel), ' '.join(serial))
+    return None
+
+
+def sweep(values):
+    return ['sweep_param=injection_rate', 'sweep_values={%s}' % ','.join(values)]
+
+
+def check_sweep(booksim, args, values):
+    output = run(booksim, args + sweep(values))
+    if 'Sweep = PASSED!' not in output:
+        return 'sweep failed'
+    if output.count('Simulation = PASSED!') != len(values):
+        return 'expected %d passing sweep points' % len(values)
+    return None
+
+
+def check_error(booksim, args, message):
+    output = run(booksim, args)
+    if message not in output:
+        return 'expected "%s"' % message
+    if 'Sweep = ' in output:
+        return 'sweep points ran anyway'
+    return None
+
+
+CHECKS = [
+    ('fattree_random_parallel_2',
+     lambda b: check_same(b, FATTREE_RANDOM, ['sim_threads=1'], ['sim_threads=2'])),
+    ('fattree_random_parallel_3',
+     lambda b: check_same(b, FATTREE_RANDOM, ['sim_threads=1'], ['sim_threads=3'])),
+    ('fattree_random_parallel_subnets',
+     lambda b: check_same(b, FATTREE_RANDOM + ['subnets=2'],
+                          ['parallel_subnets=0'], ['parallel_subnets=1'])),
+    ('mesh_iq_active_set',
+     lambda b: check_same(b, MESH_IQ, ['active_set=0'], ['active_set=1'])),
+    ('mesh_lossy_active_set',
+     lambda b: check_same(b, MESH_LOSSY, ['active_set=0'], ['active_set=1'])),
+    # the stock configuration, with the iq router every point runs its own
+    # warm-up; the lossy router shares one through a checkpoint
+    ('mesh_sweep',
+     lambda b: check_sweep(b, ['meshconfig'], ['0.01', '0.02'])),
+    ('mesh_lossy_sweep',
+     lambda b: check_sweep(b, MESH_LOSSY + ['use_endpoint_crediting=0'],
+                           ['0.01', '0.02'])),
+    # the shared warm-up must reach checkpoint_period, both when it cannot
+    # and when the simulation converges before it
+    ('mesh_lossy_sweep_late_checkpoint',
+     lambda b: check_error(b, MESH_LOSSY + COMMON + sweep(['0.01', '0.02']) +
+                           ['max_samples=2', 'checkpoint_period=5'],
+                           'checkpoint_period (5) must not exceed max_samples (2)')),
+    ('mesh_lossy_sweep_converged',
+     lambda b: check_error(b, MESH_LOSSY + COMMON + sweep(['0.01', '0.02']) +
+                           ['sample_period=1000', 'warmup_periods=1', 'max_samples=10',
+                            'checkpoint_period=8', 'stopping_thres=1.0',
+                            'acc_stopping_thres=1.0'],
+                           'no checkpoint was saved')),
+]
+
+
+def main():
+    parser = argparse.ArgumentParser(description='BookSim regression checks')
+    parser.add_argument('--booksim', default=os.path.join(os.path.dirname(
+        os.path.abspath(__file__)), '..', 'src', 'booksim'))
+    parser.add_argument('--list', action='store_true', help='list the checks and exit')
+    parser.add_argument('patterns', nargs='*', help='run only matching checks')
+    opts = parser.parse_args()
+
+    checks = [(n, c) for n, c in CHECKS
+              if not opts.patterns or any(fnmatch.fnmatchcase(n, p) for p in opts.patterns)]
+    if opts.list:
+        for name, _ in checks:
+            print(name)
+        return 0
+
+    failed = False
+    for name, check in checks:
+        error = check(opts.booksim)
+        if error:
+            failed = True
+        sys.stderr.write('%-32s %s\n' % (name, error or 'ok'))
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
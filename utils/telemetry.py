@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+
+# Reader for the telemetry files written by booksim (telemetry_file).
+#
+# usage: telemetry.py FILE                     list the columns
+#        telemetry.py FILE summary [PATTERN]   per-column mean and maximum
+#        telemetry.py FILE csv [PATTERN...]    dump rows as CSV
+#
+# PATTERNs are shell-style wildcards over the column names, e.g.
+# 'net0.router*.occupancy'. The cycle column is always included in CSV
+# output.
+
+import fnmatch
+import struct
+import sys
+from array import array
+
+MAGIC = b'BSTELEM1'
+
+
+def read(filename, patterns=None):
+    """Returns (window, names, columns) where columns maps each selected
+    name to an array of int64 values, one per row."""
+    with open(filename, 'rb') as f:
+        if f.read(8) != MAGIC:
+            raise ValueError('%s: not a telemetry file' % filename)
+        window, count = struct.unpack('=qq', f.read(16))
+        names = []
+        for _ in range(count):
+            (length,) = struct.unpack('=q', f.read(8))
+            names.append(f.read(length).decode())
+        wanted = [i == 0 or patterns is None or
+                  any(fnmatch.fnmatchcase(n, p) for p in patterns)
+                  for i, n in enumerate(names)]
+        columns = dict((n, array('q')) for n, w in zip(names, wanted) if w)
+        while True:
+            header = f.read(8)
+            if len(header) < 8:
+                break
+            (rows,) = struct.unpack('=q', header)
+            for n, w in zip(names, wanted):
+                if w:
+                    columns[n].fromfile(f, rows)
+                else:
+                    f.seek(8 * rows, 1)
+    return window, [n for n, w in zip(names, wanted) if w], columns
+
+
+def main(argv):
+    if len(argv) < 2:
+        sys.stderr.write('usage: telemetry.py FILE [summary|csv] [PATTERN...]\n')
+        return 1
+    filename = argv[1]
+    command = argv[2] if len(argv) > 2 else 'list'
+    patterns = argv[3:] or None
+
+    if command == 'list':
+        window, names, columns = read(filename)
+        print('window = %d cycles, %d rows' % (window, len(columns['cycle'])))
+        for n in names:
+            print(n)
+    elif command == 'summary':
+        window, names, columns = read(filename, patterns)
+        print('column,mean,max')
+        for n in names[1:]:
+            values = columns[n]
+            mean = float(sum(values)) / len(values) if values else 0.0
+            print('%s,%g,%d' % (n, mean, max(values) if values else 0))
+    elif command == 'csv':
+        window, names, columns = read(filename, patterns)
+        print(','.join(names))
+        for row in zip(*(columns[n] for n in names)):
+            print(','.join(str(v) for v in row))
+    else:
+        sys.stderr.write('unknown command %s\n' % command)
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))